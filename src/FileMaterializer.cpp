@@ -0,0 +1,244 @@
+#include "FileMaterializer.h"
+
+#include "MetricsRegistry.h"
+#include "TraceRecorder.h"
+#include "WorkspaceManager.h"
+
+#if JUCE_MAC
+#include <sys/clonefile.h>
+#include <unistd.h>
+#elif JUCE_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#elif JUCE_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace
+{
+MetricsRegistry::Counter& getMaterializedCounter(const String& method)
+{
+    StringPairArray labels;
+    labels.set("method", method);
+
+    return MetricsRegistry::getInstance()->getCounter(
+        "harp_materialized_files_total", "Files saved or sent to the DAW, by method.", labels);
+}
+} // namespace
+
+bool FileMaterializer::clone(const File& sourceFile, const File& targetFile)
+{
+    String sourcePathString = sourceFile.getFullPathName();
+    String targetPathString = targetFile.getFullPathName();
+
+    const char* sourcePath = sourcePathString.toRawUTF8();
+    const char* targetPath = targetPathString.toRawUTF8();
+
+#if JUCE_MAC
+    return clonefile(sourcePath, targetPath, 0) == 0;
+#elif JUCE_LINUX && defined(FICLONE)
+    int sourceFd = open(sourcePath, O_RDONLY);
+    int targetFd = open(targetPath, O_WRONLY | O_CREAT | O_EXCL, 0644);
+
+    bool cloned = sourceFd >= 0 && targetFd >= 0 && ioctl(targetFd, FICLONE, sourceFd) == 0;
+
+    if (sourceFd >= 0)
+    {
+        close(sourceFd);
+    }
+
+    if (targetFd >= 0)
+    {
+        close(targetFd);
+
+        if (! cloned)
+        {
+            unlink(targetPath);
+        }
+    }
+
+    return cloned;
+#else
+    ignoreUnused(sourcePath, targetPath);
+
+    return false;
+#endif
+}
+
+bool FileMaterializer::link(const File& sourceFile, const File& targetFile)
+{
+#if JUCE_MAC || JUCE_LINUX
+    String sourcePathString = sourceFile.getFullPathName();
+    String targetPathString = targetFile.getFullPathName();
+
+    return ::link(sourcePathString.toRawUTF8(), targetPathString.toRawUTF8()) == 0;
+#elif JUCE_WINDOWS
+    return CreateHardLinkW(targetFile.getFullPathName().toWideCharPointer(),
+                           sourceFile.getFullPathName().toWideCharPointer(),
+                           nullptr);
+#else
+    ignoreUnused(sourceFile, targetFile);
+
+    return false;
+#endif
+}
+
+void FileMaterializer::materializeAsync(const File& sourceFile,
+                                        const File& targetFile,
+                                        std::function<void(double)> onProgress,
+                                        std::function<void(bool)> onFinished)
+{
+    HARP_TRACE_SCOPE("io", "FileMaterializer::materializeAsync");
+
+    if (sourceFile == targetFile)
+    {
+        bool exists = sourceFile.existsAsFile();
+
+        MessageManager::callAsync([onFinished, exists] { onFinished(exists); });
+        return;
+    }
+
+    // Staged in the target's directory, so it can be renamed over the target
+    auto staging = std::make_shared<TemporaryFile>(targetFile, TemporaryFile::useHiddenFile);
+
+    String method;
+
+    // Both only touch metadata, so they are cheap enough for the calling thread
+    if (clone(sourceFile, staging->getFile()))
+    {
+        method = "clone";
+    }
+    else if (WorkspaceManager::getInstance()->contains(sourceFile)
+             && link(sourceFile, staging->getFile()))
+    {
+        method = "link";
+    }
+
+    if (method.isNotEmpty())
+    {
+        bool replaced = staging->overwriteTargetFileWithTemporary();
+
+        if (replaced)
+        {
+            getMaterializedCounter(method).increment();
+        }
+
+        MessageManager::callAsync([onFinished, replaced] { onFinished(replaced); });
+        return;
+    }
+
+    writeAsync(
+        targetFile,
+        [sourceFile](const File& stagedFile, const std::function<void(double)>& reportProgress)
+        {
+            HARP_TRACE_SCOPE("io", "FileMaterializer::streamCopy");
+
+            bool copied = streamCopy(sourceFile, stagedFile, reportProgress);
+
+            if (copied)
+            {
+                getMaterializedCounter("copy").increment();
+            }
+            else
+            {
+                DBG("FileMaterializer::materializeAsync: Failed to copy file "
+                    << sourceFile.getFullPathName() << ".");
+            }
+
+            return copied;
+        },
+        onProgress,
+        onFinished);
+}
+
+void FileMaterializer::writeAsync(const File& targetFile,
+                                  StagedWriter writeStagedFile,
+                                  std::function<void(double)> onProgress,
+                                  std::function<void(bool)> onFinished)
+{
+    auto staging = std::make_shared<TemporaryFile>(targetFile, TemporaryFile::useHiddenFile);
+
+    // The user is waiting on it
+    scheduler->submit(
+        TaskScheduler::Lane::Interactive,
+        [staging, writeStagedFile, onProgress, onFinished]
+        {
+            int lastPercent = -1;
+
+            // Reported at most once per percent, to not flood the message thread
+            auto reportProgress = [&lastPercent, onProgress](double progress)
+            {
+                int percent = roundToInt(jlimit(0.0, 1.0, progress) * 100.0);
+
+                if (onProgress != nullptr && percent != lastPercent)
+                {
+                    lastPercent = percent;
+
+                    MessageManager::callAsync([onProgress, percent]
+                                              { onProgress(percent / 100.0); });
+                }
+            };
+
+            bool replaced = writeStagedFile(staging->getFile(), reportProgress)
+                            && staging->overwriteTargetFileWithTemporary();
+
+            MessageManager::callAsync([onFinished, replaced] { onFinished(replaced); });
+        });
+}
+
+bool FileMaterializer::streamCopy(const File& sourceFile,
+                                  const File& targetFile,
+                                  const std::function<void(double)>& reportProgress)
+{
+    FileInputStream input(sourceFile);
+
+    if (input.failedToOpen())
+    {
+        return false;
+    }
+
+    FileOutputStream output(targetFile);
+
+    if (output.failedToOpen())
+    {
+        return false;
+    }
+
+    int64 totalBytes = jmax<int64>(1, input.getTotalLength());
+
+    HeapBlock<char> buffer(copyBufferSize);
+
+    while (! input.isExhausted())
+    {
+        if (TaskScheduler::isCurrentTaskCancelled())
+        {
+            return false;
+        }
+
+        int numBytesRead = input.read(buffer, copyBufferSize);
+
+        if (numBytesRead < 0 || ! output.write(buffer, static_cast<size_t>(numBytesRead)))
+        {
+            return false;
+        }
+
+        if (numBytesRead == 0)
+        {
+            break;
+        }
+
+        reportProgress(static_cast<double>(input.getPosition()) / static_cast<double>(totalBytes));
+    }
+
+    output.flush();
+
+    return output.getStatus().wasOk();
+}
@@ -0,0 +1,69 @@
+/**
+ * @file FileMaterializer.h
+ * @brief Places the content of a file at another path without blocking the UI
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include "TaskScheduler.h"
+
+#include <functional>
+
+using namespace juce;
+
+/*
+  Saving a track or sending it to the DAW used to copy the whole file on the
+  message thread. Instead, the content is first staged next to the target,
+  using the cheapest method available:
+
+    1. a reflink (copy-on-write clone), where the file system supports it,
+    2. a hard link, only if the source is a HARP-owned workspace file (which
+       is never modified in place),
+    3. a streamed copy in the background lane, reporting its progress.
+
+  The staged file is then renamed over the target, so a reader (e.g., the
+  DAW) never sees a half-written file. Meant to be held through a
+  SharedResourcePointer.
+*/
+class FileMaterializer
+{
+public:
+    // Copy-on-write clone of a file, where supported (the target must not exist)
+    static bool clone(const File& sourceFile, const File& targetFile);
+
+    // Hard link to a file (the target must not exist)
+    static bool link(const File& sourceFile, const File& targetFile);
+
+    /*
+      Replace the target with the content of the source. The callbacks are
+      invoked on the message thread, with the progress of a streamed copy
+      (0 to 1) and whether the target was replaced. Callers must check they
+      still exist when called back (e.g., with a SafePointer).
+    */
+    void materializeAsync(const File& sourceFile,
+                          const File& targetFile,
+                          std::function<void(double)> onProgress,
+                          std::function<void(bool)> onFinished);
+
+    // Writes a staged file on a worker thread, reporting its progress (0 to 1)
+    using StagedWriter =
+        std::function<bool(const File& stagedFile, const std::function<void(double)>& reportProgress)>;
+
+    // Like materializeAsync, for content that has to be generated (e.g., by a conversion)
+    void writeAsync(const File& targetFile,
+                    StagedWriter writeStagedFile,
+                    std::function<void(double)> onProgress,
+                    std::function<void(bool)> onFinished);
+
+private:
+    static bool streamCopy(const File& sourceFile,
+                           const File& targetFile,
+                           const std::function<void(double)>& reportProgress);
+
+    static constexpr int copyBufferSize = 1 << 20;
+
+    SharedResourcePointer<TaskScheduler> scheduler;
+};
@@ -2,29 +2,245 @@
 
 JUCE_IMPLEMENT_SINGLETON(HarpLogger)
 
+HarpLogger::HarpLogger() : Thread("HARP Logger")
+{
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
 HarpLogger::~HarpLogger()
 {
-    logger.reset(); // Explicitly reset the unique pointer to release the FileLogger
+    // Writer flushes whatever is still queued before exiting
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+
+    logStream.reset();
     clearSingletonInstance();
 }
 
 // Log a message
-void HarpLogger::LogAndDBG(const juce::String& message) const
+void HarpLogger::LogAndDBG(const juce::String& message, LogLevel level)
 {
-    if (logger)
+    // Debug output is never filtered, only what is written to the log file
+    DBG(message);
+
+    if (! isEnabled(level) || ! isThreadRunning())
+    {
+        return;
+    }
+
+    String line = Time::getCurrentTime().formatted("%Y-%m-%d %H:%M:%S") + " ["
+                  + getLevelName(level) + "] " + message;
+
+    if (! push(line))
     {
-        DBG(message);
-        logger->logMessage(message);
+        ++numDropped;
+        ++numDroppedTotal;
+        return;
+    }
+
+    // Otherwise the writer picks messages up on its next round
+    if (level == LogLevel::Error
+        || enqueuePos.load(std::memory_order_relaxed) - dequeuePos.load(std::memory_order_relaxed)
+               > capacity / 2)
+    {
+        notify();
     }
 }
 
 // Initialize the logger
 void HarpLogger::initializeLogger()
 {
+    if (isThreadRunning())
+    {
+        return;
+    }
+
     // MacOS: ~/Library/Logs/HARP/main.log
     // Linux: ~/.config/HARP/main.log
     // Windows: C:\Users\<username>\AppData\Roaming\HARP\main.log
-    logger.reset(juce::FileLogger::createDefaultAppLogger("HARP", "main.log", "Hello, HARP!"));
+    logFile = FileLogger::getSystemLogFileFolder().getChildFile("HARP").getChildFile("main.log");
+
+    logFile.create();
+    rotateIfNeeded();
+
+    logStream = std::make_unique<FileOutputStream>(logFile);
+
+    if (logStream->failedToOpen())
+    {
+        DBG("HarpLogger::initializeLogger: Failed to open log file " << logFile.getFullPathName()
+                                                                     << ".");
+        logStream.reset();
+        return;
+    }
+
+    *logStream << newLine << "**********************************************************" << newLine
+               << "Hello, HARP!" << newLine
+               << "Log started: " << Time::getCurrentTime().toString(true, true) << newLine;
+
+    startThread(Thread::Priority::low);
+}
+
+juce::File HarpLogger::getLogFile() const { return logFile; }
+
+void HarpLogger::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(writeIntervalMs);
+
+        writePendingMessages();
+    }
+
+    // Whatever was logged up to shutdown
+    writePendingMessages();
 }
 
-juce::File HarpLogger::getLogFile() const { return logger->getLogFile(); }
+// Bounded MPSC queue, where each cell's sequence number tells producers and
+// the writer whose turn it is to use the cell
+bool HarpLogger::push(const String& line)
+{
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        Cell& cell = cells[pos & (capacity - 1)];
+
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+        if (diff == 0)
+        {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.line = line;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Full
+            return false;
+        }
+        else
+        {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Only called on the writer thread
+bool HarpLogger::pop(String& line)
+{
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+
+    Cell& cell = cells[pos & (capacity - 1)];
+
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+    if (static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1) < 0)
+    {
+        // Empty
+        return false;
+    }
+
+    line = std::move(cell.line);
+    cell.line = String();
+    cell.sequence.store(pos + capacity, std::memory_order_release);
+
+    dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+void HarpLogger::writePendingMessages()
+{
+    if (logStream == nullptr)
+    {
+        return;
+    }
+
+    String line;
+    bool wroteAny = false;
+
+    while (pop(line))
+    {
+        *logStream << line << newLine;
+        wroteAny = true;
+    }
+
+    if (int dropped = numDropped.exchange(0); dropped > 0)
+    {
+        *logStream << Time::getCurrentTime().formatted("%Y-%m-%d %H:%M:%S") << " ["
+                   << getLevelName(LogLevel::Warning) << "] " << dropped
+                   << " messages dropped, since the log queue was full." << newLine;
+        wroteAny = true;
+    }
+
+    if (! wroteAny)
+    {
+        return;
+    }
+
+    logStream->flush();
+
+    if (logStream->getPosition() > maxLogFileSize)
+    {
+        logStream.reset();
+
+        rotateIfNeeded();
+
+        logStream = std::make_unique<FileOutputStream>(logFile);
+
+        if (logStream->failedToOpen())
+        {
+            logStream.reset();
+        }
+    }
+}
+
+void HarpLogger::rotateIfNeeded()
+{
+    if (logFile.getSize() <= maxLogFileSize)
+    {
+        return;
+    }
+
+    auto getBackupFile = [this](int idx)
+    {
+        return logFile.getSiblingFile(logFile.getFileNameWithoutExtension() + "." + String(idx)
+                                      + ".log");
+    };
+
+    // main.log -> main.1.log -> main.2.log -> ..., dropping the oldest
+    getBackupFile(numBackupFiles).deleteFile();
+
+    for (int idx = numBackupFiles - 1; idx >= 1; --idx)
+    {
+        getBackupFile(idx).moveFileTo(getBackupFile(idx + 1));
+    }
+
+    logFile.moveFileTo(getBackupFile(1));
+}
+
+String HarpLogger::getLevelName(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::Debug:
+            return "DEBUG";
+        case LogLevel::Info:
+            return "INFO";
+        case LogLevel::Warning:
+            return "WARNING";
+        case LogLevel::Error:
+            return "ERROR";
+    }
+
+    return {};
+}
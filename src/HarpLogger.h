@@ -3,38 +3,133 @@
 #include <juce_core/juce_core.h>
 #include <juce_events/juce_events.h>
 
+#include <array>
+#include <atomic>
+
 #include "client/Client.h"
 
 using namespace juce;
 
-class HarpLogger : private DeletedAtShutdown
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+// Messages below this level are compiled out of HARP_LOG (0 = Debug, ..., 3 = Error)
+#ifndef HARP_LOG_MIN_LEVEL
+#if JUCE_DEBUG
+#define HARP_LOG_MIN_LEVEL 0
+#else
+#define HARP_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+/*
+  Messages are pushed into a bounded lock-free queue and written to disk by a
+  background thread, so logging never waits on a lock or on the disk. If the
+  queue is full, the message is dropped and counted instead, and the number
+  of dropped messages is noted in the log once there is room again. The log
+  file is rotated once it grows beyond a size limit, keeping a few of the
+  previous files next to it (main.1.log, main.2.log, ...).
+*/
+class HarpLogger : private DeletedAtShutdown, private Thread
 {
 public:
     // singleton instance of Logger
     JUCE_DECLARE_SINGLETON(HarpLogger, false)
 
-    ~HarpLogger();
+    ~HarpLogger() override;
 
     // Disable copy constructor and assignment operator
     HarpLogger(const HarpLogger&) = delete;
     HarpLogger& operator=(const HarpLogger&) = delete;
 
-    void LogAndDBG(const juce::String& message) const;
+    void LogAndDBG(const juce::String& message, LogLevel level = LogLevel::Info);
 
     void initializeLogger();
 
     juce::File getLogFile() const;
 
+    // Runtime filter of the log file, on top of HARP_LOG_MIN_LEVEL
+    void setMinLevel(LogLevel level) { minLevel = level; }
+    bool isEnabled(LogLevel level) const { return level >= minLevel.load(); }
+
+    // Whether a message would go anywhere (debug builds print every message with DBG)
+    bool isWanted(LogLevel level) const
+    {
+#if JUCE_DEBUG
+        ignoreUnused(level);
+        return true;
+#else
+        return isEnabled(level);
+#endif
+    }
+
+    int64 getNumDropped() const { return numDroppedTotal.load(); }
+
 private:
     // Private constructor to prevent instantiation from outside
-    HarpLogger() = default;
+    HarpLogger();
+
+    void run() override;
+
+    bool push(const String& line);
+    bool pop(String& line);
+
+    void writePendingMessages();
+    void rotateIfNeeded();
 
-    std::unique_ptr<juce::FileLogger> logger { nullptr };
+    static String getLevelName(LogLevel level);
+
+    // Must be a power of two
+    static constexpr size_t capacity = 4096;
+
+    static constexpr int64 maxLogFileSize = 5 * 1024 * 1024;
+    static constexpr int numBackupFiles = 3;
+
+    // Writer wakes up this often, unless woken up early for an error or a filling queue
+    static constexpr int writeIntervalMs = 250;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence { 0 };
+        String line;
+    };
+
+    std::array<Cell, capacity> cells;
+
+    std::atomic<size_t> enqueuePos { 0 };
+    std::atomic<size_t> dequeuePos { 0 };
+
+    std::atomic<LogLevel> minLevel { LogLevel::Debug };
+
+    // Dropped since last noted in the log, and overall
+    std::atomic<int> numDropped { 0 };
+    std::atomic<int64> numDroppedTotal { 0 };
+
+    juce::File logFile;
+    std::unique_ptr<FileOutputStream> logStream;
 };
 
 // Function for easier access to logging
 // without having to write HarpLogger::getInstance()->LogAndDBG(message) every time
-inline void LogAndDBG(const juce::String& message)
+inline void LogAndDBG(const juce::String& message, LogLevel level = LogLevel::Info)
 {
-    HarpLogger::getInstance()->LogAndDBG(message);
+    HarpLogger::getInstance()->LogAndDBG(message, level);
 }
+
+// Logs at a fixed level, without even building the message if the level is compiled out
+#define HARP_LOG(level, message)                                                                   \
+    do                                                                                             \
+    {                                                                                              \
+        if constexpr (static_cast<int>(level) >= HARP_LOG_MIN_LEVEL)                               \
+        {                                                                                          \
+            if (HarpLogger::getInstance()->isWanted(level))                                        \
+            {                                                                                      \
+                LogAndDBG(message, level);                                                         \
+            }                                                                                      \
+        }                                                                                          \
+    } while (false)
@@ -1,5 +1,7 @@
 #include "MainComponent.h"
 #include "AppSettings.h"
+#include "StartupProfiler.h"
+#include "TraceRecorder.h"
 
 using namespace juce;
 
@@ -8,6 +10,10 @@ class GuiAppApplication : public JUCEApplication
 public:
     GuiAppApplication()
     {
+        StartupProfiler::getInstance()->begin();
+
+        HARP_STARTUP_PHASE("settings");
+
         PropertiesFile::Options options;
 
         options.applicationName = getApplicationName();
@@ -51,6 +57,11 @@ public:
         appJustLaunched = true;
         originalCommandLine = commandLine;
 
+        if (commandLine.contains("--trace") || AppSettings::getBoolValue("enableTracing", false))
+        {
+            startTracing();
+        }
+
         String windowTitle = getApplicationName();
 
         if (windowCounter > 1)
@@ -60,19 +71,43 @@ public:
 
         windowCounter++;
 
-        mainWindow.reset(new HARPWindow(windowTitle));
+        {
+            HARP_STARTUP_PHASE("window");
+
+            mainWindow.reset(new HARPWindow(windowTitle));
+        }
 
         StringArray args;
 
         // Split command line arguments at spaces
         args.addTokens(commandLine.trim(), " ", "\"");
 
-        importInitialFiles(args);
+        args.removeString("--trace");
+
+        {
+            HARP_STARTUP_PHASE("initial files");
+
+            importInitialFiles(args);
+        }
 
         // Assumes app can't be re-invoked manually within 500ms of initial launch
         Timer::callAfterDelay(500, [this]() { appJustLaunched = false; });
     }
 
+    void startTracing()
+    {
+        // Written next to main.log when the application quits
+        File traceFile = FileLogger::getSystemLogFileFolder()
+                             .getChildFile("HARP")
+                             .getChildFile("trace_"
+                                           + Time::getCurrentTime().formatted("%Y%m%d_%H%M%S")
+                                           + ".json");
+
+        traceFile.create();
+
+        TraceRecorder::getInstance()->start(traceFile);
+    }
+
     void importInitialFiles(StringArray files)
     {
         for (auto f : files)
@@ -156,6 +191,8 @@ public:
     {
         // Delete our window
         mainWindow = nullptr;
+
+        TraceRecorder::getInstance()->stop();
     }
 
     /**
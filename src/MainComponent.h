@@ -14,7 +14,6 @@
 
 #include "widgets/ControlAreaWidget.h"
 #include "widgets/MediaClipboardWidget.h"
-#include "ThreadPoolJob.h"
 #include "widgets/TrackAreaWidget.h"
 #include "WebModel.h"
 
@@ -28,6 +27,10 @@
 #include "client/Client.h"
 
 #include "HarpLogger.h"
+#include "MetricsRegistry.h"
+#include "StartupProfiler.h"
+#include "TaskScheduler.h"
+#include "WorkspaceManager.h"
 #include "external/magic_enum.hpp"
 // #include "media/AudioDisplayComponent.h"
 // #include "media/MediaDisplayComponent.h"
@@ -150,8 +153,8 @@ public:
             menu.addCommandItem(&commandManager, CommandIDs::open);
             //menu.addCommandItem(&commandManager, CommandIDs::save);
             menu.addCommandItem(&commandManager, CommandIDs::saveAs);
-            //menu.addCommandItem(&commandManager, CommandIDs::undo);
-            //menu.addCommandItem(&commandManager, CommandIDs::redo);
+            menu.addCommandItem(&commandManager, CommandIDs::undo);
+            menu.addCommandItem(&commandManager, CommandIDs::redo);
             menu.addSeparator();
             menu.addCommandItem(&commandManager, CommandIDs::settings);
             menu.addSeparator();
@@ -310,12 +313,12 @@ public:
             return;
         }
 
-        // Iterate over all inputMediaDisplays and call the iteratePreviousTempFile()
-        auto& inputMediaDisplays = inputTrackAreaWidget.getMediaDisplays();
+        // Iterate over all outputMediaDisplays and call the iteratePreviousTempFile()
+        auto& outputMediaDisplays = outputTrackAreaWidget.getMediaDisplays();
 
-        /*for (auto& inputMediaDisplay : inputMediaDisplays)
+        for (auto& outputMediaDisplay : outputMediaDisplays)
         {
-            if (! inputMediaDisplay->iteratePreviousTempFile())
+            if (! outputMediaDisplay->iteratePreviousTempFile())
             {
                 DBG("Nothing to undo!");
                 // juce::LookAndFeel::getDefaultLookAndFeel().playAlertSound();
@@ -325,7 +328,7 @@ public:
                 saveEnabled = true;
                 DBG("Undo callback completed successfully");
             }
-        }*/
+        }
     }
 
     void redoCallback()
@@ -349,12 +352,12 @@ public:
             return;
         }
 
-        // Iterate over all inputMediaDisplays and call the iterateNextTempFile()
-        auto& inputMediaDisplays = inputTrackAreaWidget.getMediaDisplays();
+        // Iterate over all outputMediaDisplays and call the iterateNextTempFile()
+        auto& outputMediaDisplays = outputTrackAreaWidget.getMediaDisplays();
 
-        /*for (auto& inputMediaDisplay : inputMediaDisplays)
+        for (auto& outputMediaDisplay : outputMediaDisplays)
         {
-            if (! inputMediaDisplay->iterateNextTempFile())
+            if (! outputMediaDisplay->iterateNextTempFile())
             {
                 DBG("Nothing to redo!");
                 // juce::LookAndFeel::getDefaultLookAndFeel().playAlertSound();
@@ -364,7 +367,7 @@ public:
                 saveEnabled = true;
                 DBG("Redo callback completed successfully");
             }
-        }*/
+        }
     }
 
     void tryLoadSavedToken()
@@ -419,8 +422,10 @@ public:
         processCancelButton.setEnabled(false);
 
         // loading happens asynchronously.
-        threadPool.addJob(
-            [this, params]
+        // The task only holds on to the model, as it may outlive this component
+        submitTask(
+            TaskScheduler::Lane::Network,
+            [safeThis = Component::SafePointer<MainComponent>(this), loadingModel = model, params]
             {
                 try
                 {
@@ -429,197 +434,36 @@ public:
                     // set the last status to the current status
                     // If loading of the new model fails,
                     // we want to go back to the status we had before the failed attempt
-                    model->setLastStatus(model->getStatus());
+                    loadingModel->setLastStatus(loadingModel->getStatus());
 
-                    OpResult loadingResult = model->load(params);
+                    OpResult loadingResult = loadingModel->load(params);
                     if (loadingResult.failed())
                     {
                         throw loadingResult.getError();
                     }
 
                     // loading succeeded
-                    // Do some UI stuff to add the new model to the comboBox
-                    // if it's not already there
-                    // and update the lastSelectedItemIndex and lastLoadedModelItemIndex
                     MessageManager::callAsync(
-                        [this, loadingResult]
+                        [safeThis, loadingResult]
                         {
-                            resetUI();
-                            if (modelPathComboBox.getSelectedItemIndex() == 0)
-                            {
-                                bool alreadyInComboBox = false;
-
-                                for (int i = 0; i < modelPathComboBox.getNumItems(); ++i)
-                                {
-                                    if (modelPathComboBox.getItemText(i)
-                                        == (juce::String) customPath)
-                                    {
-                                        alreadyInComboBox = true;
-                                        modelPathComboBox.setSelectedId(i + 1);
-                                        lastSelectedItemIndex = i;
-                                        lastLoadedModelItemIndex = i;
-                                    }
-                                }
-
-                                if (! alreadyInComboBox)
-                                {
-                                    int new_id = modelPathComboBox.getNumItems() + 1;
-                                    modelPathComboBox.addItem(customPath, new_id);
-                                    modelPathComboBox.setSelectedId(new_id);
-                                    lastSelectedItemIndex = new_id - 1;
-                                    lastLoadedModelItemIndex = new_id - 1;
-                                }
-                            }
-                            else
+                            if (safeThis != nullptr)
                             {
-                                lastLoadedModelItemIndex = modelPathComboBox.getSelectedItemIndex();
+                                safeThis->handleModelLoaded(loadingResult);
                             }
-                            processLoadingResult(loadingResult);
                         });
                 }
                 catch (Error& loadingError)
                 {
                     Error::fillUserMessage(loadingError);
-                    LogAndDBG("Error in Model Loading:\n" + loadingError.devMessage);
-                    auto msgOpts =
-                        MessageBoxOptions()
-                            .withTitle("Loading Error")
-                            .withIconType(AlertWindow::WarningIcon)
-                            .withTitle("Error")
-                            .withMessage("An error occurred while loading the WebModel: \n"
-                                         + loadingError.userMessage);
-                    // if (! String(e.what()).contains("404")
-                    //     && ! String(e.what()).contains("Invalid URL"))
-                    if (loadingError.type != ErrorType::InvalidURL)
-                    {
-                        msgOpts = msgOpts.withButton("Open Space URL");
-                    }
-
-                    msgOpts = msgOpts.withButton("Open HARP Logs").withButton("Ok");
-                    auto alertCallback = [this, msgOpts, loadingError](int result)
-                    {
-                        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-                        // NOTE (hugo): there's something weird about the button indices assigned by the msgOpts here
-                        // DBG("ALERT-CALLBACK: buttonClicked alertCallback listener activated: chosen: " << chosen);
-                        // auto chosen = msgOpts.getButtonText(result);
-                        // they're not the same as the order of the buttons in the alert
-                        // this is the order that I actually observed them to be.
-                        // UPDATE/TODO (xribene): This should be fixed in Juce v8
-                        // see: https://forum.juce.com/t/wrong-callback-value-for-alertwindow-showokcancelbox/55671/2
-                        // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-                        std::map<int, std::string> observedButtonIndicesMap = {};
-                        if (msgOpts.getNumButtons() == 3)
-                        {
-                            observedButtonIndicesMap.insert(
-                                { 1, "Open Space URL" }); // should actually be 0 right?
-                        }
-                        observedButtonIndicesMap.insert(
-                            { msgOpts.getNumButtons() - 1,
-                              "Open HARP Logs" }); // should actually be 1
-                        observedButtonIndicesMap.insert({ 0, "Ok" }); // should be 2
-
-                        auto chosen = observedButtonIndicesMap[result];
-
-                        if (chosen == "Open HARP Logs")
-                        {
-                            HarpLogger::getInstance()->getLogFile().revealToUser();
-                        }
-                        else if (chosen == "Open Space URL")
+                    LogAndDBG("Error in Model Loading:\n" + loadingError.devMessage, LogLevel::Error);
+                    MessageManager::callAsync(
+                        [safeThis, loadingError]
                         {
-                            // get the spaceInfo
-                            SpaceInfo spaceInfo = model->getTempClient().getSpaceInfo();
-                            if (spaceInfo.status == SpaceInfo::Status::GRADIO)
-                            {
-                                URL spaceUrl = this->model->getTempClient().getSpaceInfo().gradio;
-                                spaceUrl.launchInDefaultBrowser();
-                            }
-                            else if (spaceInfo.status == SpaceInfo::Status::HUGGINGFACE)
-                            {
-                                URL spaceUrl = this->model->getTempClient().getSpaceInfo().huggingface;
-                                spaceUrl.launchInDefaultBrowser();
-                            }
-                            else if (spaceInfo.status == SpaceInfo::Status::LOCALHOST)
-                            {
-                                // either choose hugingface or gradio, they are the same
-                                URL spaceUrl = this->model->getTempClient().getSpaceInfo().huggingface;
-                                spaceUrl.launchInDefaultBrowser();
-                            }
-                            else if (spaceInfo.status == SpaceInfo::Status::STABILITY)
+                            if (safeThis != nullptr)
                             {
-                                URL spaceUrl = this->model->getTempClient().getSpaceInfo().stability;
-                                spaceUrl.launchInDefaultBrowser();
+                                safeThis->handleModelLoadFailed(loadingError);
                             }
-                            // URL spaceUrl =
-                            //     this->model->getGradioClient().getSpaceInfo().huggingface;
-                            // spaceUrl.launchInDefaultBrowser();
-                        }
-
-                        if (lastLoadedModelItemIndex == -1)
-                        {
-                            // If before the failed attempt to load a new model, we HAD NO model loaded
-                            // TODO: these two functions we call here might be an overkill for this case
-                            // we need to simplify
-                            MessageManager::callAsync(
-                                [this, loadingError]
-                                {
-                                    resetModelPathComboBox();
-                                    model->setStatus(ModelStatus::INITIALIZED);
-                                    processLoadingResult(OpResult::fail(loadingError));
-                                });
-                        }
-                        else
-                        {
-                            // If before the failed attempt to load a new model, we HAD a model loaded
-                            MessageManager::callAsync(
-                                [this, loadingError]
-                                {
-                                    // We set the status to
-                                    // the status of the model before the failed attempt
-                                    model->setStatus(model->getLastStatus());
-                                    processLoadingResult(OpResult::fail(loadingError));
-                                });
-                        }
-
-                        // This if/elseif/else block is responsible for setting the selected item
-                        // in the modelPathComboBox to the correct item (i.e the model/path/app that
-                        // was selected before the failed attempt to load a new model)
-                        // cb: sometimes setSelectedId it doesn't work and I dont know why.
-                        // I've tried nesting it in MessageManage::callAsync, but still nothing.
-                        if (lastLoadedModelItemIndex != -1)
-                        {
-                            modelPathComboBox.setSelectedId(lastLoadedModelItemIndex + 1);
-                        }
-                        else if (lastLoadedModelItemIndex == -1 && lastSelectedItemIndex != -1)
-                        {
-                            modelPathComboBox.setSelectedId(lastSelectedItemIndex + 1);
-                        }
-                        else
-                        {
-                            resetModelPathComboBox();
-                            MessageManager::callAsync([this, loadingError]
-                                                      { loadModelButton.setEnabled(false); });
-                        }
-                        /*
-                        if (loadingError.userMessage.containsIgnoreCase("sleeping"))
-                        {
-                            MessageManager::callAsync(
-                                [this]
-                                {
-                                    addCustomPathToDropdown(customPath, true); // mark as sleeping
-                                });
-                        }
-                        //NEW: reopen custom path dialog if sleeping or 404
-                        if (loadingError.type == ErrorType::InvalidURL
-                            || loadingError.devMessage.contains("404")
-                            || loadingError.userMessage.containsIgnoreCase("sleeping"))
-                        {
-                            MessageManager::callAsync([this] { openCustomPathDialog(customPath); });
-                        }
-                        */
-                    };
-
-                    AlertWindow::showAsync(msgOpts, alertCallback);
-                    saveEnabled = false;
+                        });
                 }
                 catch (const std::exception& e)
                 {
@@ -639,6 +483,187 @@ public:
             });
     }
 
+    // Do some UI stuff to add the new model to the comboBox
+    // if it's not already there
+    // and update the lastSelectedItemIndex and lastLoadedModelItemIndex
+    void handleModelLoaded(const OpResult& loadingResult)
+    {
+        resetUI();
+        if (modelPathComboBox.getSelectedItemIndex() == 0)
+        {
+            bool alreadyInComboBox = false;
+
+            for (int i = 0; i < modelPathComboBox.getNumItems(); ++i)
+            {
+                if (modelPathComboBox.getItemText(i)
+                    == (juce::String) customPath)
+                {
+                    alreadyInComboBox = true;
+                    modelPathComboBox.setSelectedId(i + 1);
+                    lastSelectedItemIndex = i;
+                    lastLoadedModelItemIndex = i;
+                }
+            }
+
+            if (! alreadyInComboBox)
+            {
+                int new_id = modelPathComboBox.getNumItems() + 1;
+                modelPathComboBox.addItem(customPath, new_id);
+                modelPathComboBox.setSelectedId(new_id);
+                lastSelectedItemIndex = new_id - 1;
+                lastLoadedModelItemIndex = new_id - 1;
+            }
+        }
+        else
+        {
+            lastLoadedModelItemIndex = modelPathComboBox.getSelectedItemIndex();
+        }
+        processLoadingResult(loadingResult);
+    }
+
+    void handleModelLoadFailed(const Error& loadingError)
+    {
+        auto msgOpts =
+            MessageBoxOptions()
+                .withTitle("Loading Error")
+                .withIconType(AlertWindow::WarningIcon)
+                .withTitle("Error")
+                .withMessage("An error occurred while loading the WebModel: \n"
+                             + loadingError.userMessage);
+        // if (! String(e.what()).contains("404")
+        //     && ! String(e.what()).contains("Invalid URL"))
+        if (loadingError.type != ErrorType::InvalidURL)
+        {
+            msgOpts = msgOpts.withButton("Open Space URL");
+        }
+
+        msgOpts = msgOpts.withButton("Open HARP Logs").withButton("Ok");
+        auto alertCallback = [this, msgOpts, loadingError](int result)
+        {
+            // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+            // NOTE (hugo): there's something weird about the button indices assigned by the msgOpts here
+            // DBG("ALERT-CALLBACK: buttonClicked alertCallback listener activated: chosen: " << chosen);
+            // auto chosen = msgOpts.getButtonText(result);
+            // they're not the same as the order of the buttons in the alert
+            // this is the order that I actually observed them to be.
+            // UPDATE/TODO (xribene): This should be fixed in Juce v8
+            // see: https://forum.juce.com/t/wrong-callback-value-for-alertwindow-showokcancelbox/55671/2
+            // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+            std::map<int, std::string> observedButtonIndicesMap = {};
+            if (msgOpts.getNumButtons() == 3)
+            {
+                observedButtonIndicesMap.insert(
+                    { 1, "Open Space URL" }); // should actually be 0 right?
+            }
+            observedButtonIndicesMap.insert(
+                { msgOpts.getNumButtons() - 1,
+                  "Open HARP Logs" }); // should actually be 1
+            observedButtonIndicesMap.insert({ 0, "Ok" }); // should be 2
+
+            auto chosen = observedButtonIndicesMap[result];
+
+            if (chosen == "Open HARP Logs")
+            {
+                HarpLogger::getInstance()->getLogFile().revealToUser();
+            }
+            else if (chosen == "Open Space URL")
+            {
+                // get the spaceInfo
+                SpaceInfo spaceInfo = model->getTempClient().getSpaceInfo();
+                if (spaceInfo.status == SpaceInfo::Status::GRADIO)
+                {
+                    URL spaceUrl = this->model->getTempClient().getSpaceInfo().gradio;
+                    spaceUrl.launchInDefaultBrowser();
+                }
+                else if (spaceInfo.status == SpaceInfo::Status::HUGGINGFACE)
+                {
+                    URL spaceUrl = this->model->getTempClient().getSpaceInfo().huggingface;
+                    spaceUrl.launchInDefaultBrowser();
+                }
+                else if (spaceInfo.status == SpaceInfo::Status::LOCALHOST)
+                {
+                    // either choose hugingface or gradio, they are the same
+                    URL spaceUrl = this->model->getTempClient().getSpaceInfo().huggingface;
+                    spaceUrl.launchInDefaultBrowser();
+                }
+                else if (spaceInfo.status == SpaceInfo::Status::STABILITY)
+                {
+                    URL spaceUrl = this->model->getTempClient().getSpaceInfo().stability;
+                    spaceUrl.launchInDefaultBrowser();
+                }
+                // URL spaceUrl =
+                //     this->model->getGradioClient().getSpaceInfo().huggingface;
+                // spaceUrl.launchInDefaultBrowser();
+            }
+
+            if (lastLoadedModelItemIndex == -1)
+            {
+                // If before the failed attempt to load a new model, we HAD NO model loaded
+                // TODO: these two functions we call here might be an overkill for this case
+                // we need to simplify
+                MessageManager::callAsync(
+                    [this, loadingError]
+                    {
+                        resetModelPathComboBox();
+                        model->setStatus(ModelStatus::INITIALIZED);
+                        processLoadingResult(OpResult::fail(loadingError));
+                    });
+            }
+            else
+            {
+                // If before the failed attempt to load a new model, we HAD a model loaded
+                MessageManager::callAsync(
+                    [this, loadingError]
+                    {
+                        // We set the status to
+                        // the status of the model before the failed attempt
+                        model->setStatus(model->getLastStatus());
+                        processLoadingResult(OpResult::fail(loadingError));
+                    });
+            }
+
+            // This if/elseif/else block is responsible for setting the selected item
+            // in the modelPathComboBox to the correct item (i.e the model/path/app that
+            // was selected before the failed attempt to load a new model)
+            // cb: sometimes setSelectedId it doesn't work and I dont know why.
+            // I've tried nesting it in MessageManage::callAsync, but still nothing.
+            if (lastLoadedModelItemIndex != -1)
+            {
+                modelPathComboBox.setSelectedId(lastLoadedModelItemIndex + 1);
+            }
+            else if (lastLoadedModelItemIndex == -1 && lastSelectedItemIndex != -1)
+            {
+                modelPathComboBox.setSelectedId(lastSelectedItemIndex + 1);
+            }
+            else
+            {
+                resetModelPathComboBox();
+                MessageManager::callAsync([this, loadingError]
+                                          { loadModelButton.setEnabled(false); });
+            }
+            /*
+            if (loadingError.userMessage.containsIgnoreCase("sleeping"))
+            {
+                MessageManager::callAsync(
+                    [this]
+                    {
+                        addCustomPathToDropdown(customPath, true); // mark as sleeping
+                    });
+            }
+            //NEW: reopen custom path dialog if sleeping or 404
+            if (loadingError.type == ErrorType::InvalidURL
+                || loadingError.devMessage.contains("404")
+                || loadingError.userMessage.containsIgnoreCase("sleeping"))
+            {
+                MessageManager::callAsync([this] { openCustomPathDialog(customPath); });
+            }
+            */
+        };
+
+        AlertWindow::showAsync(msgOpts, alertCallback);
+        saveEnabled = false;
+    }
+
     void viewMediaClipboardCallback()
     {
         // Toggle media clipboard visibility state
@@ -1025,7 +1050,22 @@ public:
     explicit MainComponent() //: jobsFinished(0), totalJobs(0)
     //   jobProcessorThread(customJobs, jobsFinished, totalJobs, processBroadcaster)
     {
-        HarpLogger::getInstance()->initializeLogger();
+        {
+            HARP_STARTUP_PHASE("logging");
+
+            HarpLogger::getInstance()->initializeLogger();
+            HarpLogger::getInstance()->setMinLevel(static_cast<LogLevel>(
+                AppSettings::getIntValue("logLevel", static_cast<int>(LogLevel::Info))));
+            MetricsRegistry::getInstance()->startExporting(
+                HarpLogger::getInstance()->getLogFile().getParentDirectory());
+        }
+
+        {
+            HARP_STARTUP_PHASE("workspace");
+
+            // Also starts clearing files of crashed sessions in the background
+            WorkspaceManager::getInstance();
+        }
         fontaudioHelper = std::make_shared<fontaudio::IconHelper>();
         fontawesomeHelper = std::make_shared<fontawesome::IconHelper>();
 
@@ -1054,19 +1094,27 @@ public:
 
         initLoadModelButton();
 
-        // add a status timer to update the status label periodically
-        mModelStatusTimer = std::make_unique<ModelStatusTimer>(model);
-        mModelStatusTimer->addChangeListener(this);
-        mModelStatusTimer->startTimer(50); // 100 ms interval
+        // Model pushes every status transition as it happens
+        model->getStatusChannel().onStatusChanged = [this](const ModelStatusUpdate& update)
+        {
+            DBG("MainComponent::onStatusChanged: "
+                << std::string(magic_enum::enum_name(update.status)) << " ("
+                << Time::getMillisecondCounterHiRes() - update.timeInMs << " ms ago).");
+            setStatus(update.status);
+        };
 
         initModelPathComboBox();
 
         addAndMakeVisible(mediaClipboardWidget);
 
         // model controls
-        controlAreaWidget.setModel(model);
-        addAndMakeVisible(controlAreaWidget);
-        controlAreaWidget.populateControls();
+        {
+            HARP_STARTUP_PHASE("controls");
+
+            controlAreaWidget.setModel(model);
+            addAndMakeVisible(controlAreaWidget);
+            controlAreaWidget.populateControls();
+        }
 
         inputTracksLabel.setJustificationType(juce::Justification::centred);
         inputTracksLabel.setFont(juce::Font(20.0f, juce::Font::bold));
@@ -1076,7 +1124,11 @@ public:
         outputTracksLabel.setFont(juce::Font(20.0f, juce::Font::bold));
         addAndMakeVisible(outputTracksLabel);
 
-        populateTracks();
+        {
+            HARP_STARTUP_PHASE("tracks");
+
+            populateTracks();
+        }
         addAndMakeVisible(inputTrackAreaWidget);
         addAndMakeVisible(outputTrackAreaWidget);
 
@@ -1105,16 +1157,29 @@ public:
     ~MainComponent() override
     {
         // remove listeners
-        mModelStatusTimer->removeChangeListener(this);
+        model->getStatusChannel().onStatusChanged = nullptr;
         loadBroadcaster.removeChangeListener(this);
         processBroadcaster.removeChangeListener(this);
 
-        // jobProcessorThread.signalThreadShouldExit();
-        // This will not actually run any processing task
-        // It'll just make sure that the thread is not waiting
-        // and it'll allow it to check for the threadShouldExit flag
-        // jobProcessorThread.signalTask();
-        // jobProcessorThread.waitForThreadToExit(-1);
+        // Abort the request in flight, rather than wait for the server to answer
+        if (isProcessing)
+        {
+            model->cancel();
+        }
+
+        // Tasks only share the model, so a bounded wait is enough
+        for (auto& task : pendingTasks)
+        {
+            task->cancel();
+        }
+
+        for (auto& task : pendingTasks)
+        {
+            if (! task->waitForCompletion(5000))
+            {
+                DBG("MainComponent::~MainComponent: task still running after 5s.");
+            }
+        }
 
 #if JUCE_MAC
         MenuBarModel::setMacMainMenu(nullptr);
@@ -1122,6 +1187,17 @@ public:
         // commandManager.setFirstCommandTarget (nullptr);
     }
 
+    // Keeps the handle until the task has finished, so the destructor can wait for it
+    void submitTask(TaskScheduler::Lane lane, std::function<void()> task)
+    {
+        pendingTasks.erase(std::remove_if(pendingTasks.begin(),
+                                          pendingTasks.end(),
+                                          [](const auto& t) { return t->hasFinished(); }),
+                           pendingTasks.end());
+
+        pendingTasks.push_back(scheduler->submit(lane, std::move(task)));
+    }
+
     void cancelCallback()
     {
         DBG("HARPProcessorEditor::buttonClicked cancel button listener activated");
@@ -1130,7 +1206,7 @@ public:
 
         if (cancelResult.failed())
         {
-            LogAndDBG(cancelResult.getError().devMessage.toStdString());
+            LogAndDBG(cancelResult.getError().devMessage.toStdString(), LogLevel::Error);
             AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,
                                              "Cancel Error",
                                              "An error occurred while cancelling the processing: \n"
@@ -1204,61 +1280,64 @@ public:
                     std::make_tuple(inputMediaDisplay->getDisplayID(),
                                     inputMediaDisplay->getTrackName(),
                                     //inputMediaDisplay->getTempFilePath().getLocalFile()));
-                                    inputMediaDisplay->getOriginalFilePath().getLocalFile()));
+                                    inputMediaDisplay->getFileForUpload()));
             }
         }
 
-        // Directly add the job to the thread pool
-        jobProcessorThread.addJob(
-            new CustomThreadPoolJob(
-                [this, localInputTrackFiles](String jobProcessID) { // &jobsFinished, totalJobs
-                    // Individual job code for each iteration
-                    // copy the audio file, with the same filename except for an added _harp to the stem
-                    OpResult processingResult =
-                        model->process(localInputTrackFiles);
-                    processMutex.lock();
-                    if (jobProcessID != currentProcessID)
-                    {
-                        DBG("ProcessID " + jobProcessID + " not found");
-                        DBG("NumJobs: " + std::to_string(jobProcessorThread.getNumJobs()));
-                        DBG("NumThrds: " + std::to_string(jobProcessorThread.getNumThreads()));
-                        processMutex.unlock();
-                        return;
-                    }
-                    if (processingResult.failed())
+        // Processing mostly waits on the server, so it runs in the network lane
+        submitTask(
+            TaskScheduler::Lane::Network,
+            [safeThis = Component::SafePointer<MainComponent>(this),
+             processingModel = model,
+             localInputTrackFiles,
+             jobProcessID = processID]
+            {
+                // Individual job code for each iteration
+                // copy the audio file, with the same filename except for an added _harp to the stem
+                OpResult processingResult = processingModel->process(localInputTrackFiles);
+
+                MessageManager::callAsync(
+                    [safeThis, jobProcessID, processingResult]
                     {
-                        Error processingError = processingResult.getError();
-                        Error::fillUserMessage(processingError);
-                        LogAndDBG("Error in Processing:\n"
-                                  + processingError.devMessage.toStdString());
-                        AlertWindow::showMessageBoxAsync(
-                            AlertWindow::WarningIcon,
-                            "Processing Error",
-                            "An error occurred while processing the audio file: \n"
-                                + processingError.userMessage);
-                        // cb: I commented this out, and it doesn't seem to change anything
-                        // it was also causing a crash. If we need it, it needs to run on
-                        // the message thread using MessageManager::callAsync
-                        // hy: Now this line works.
-                        // resetProcessingButtons();
-                        // cb: Needs to be in the message thread or else it crashes
-                        // It's used when the processing fails to reset the process/cancel
-                        // button back to the process mode.
-                        MessageManager::callAsync([this] { resetProcessingButtons(); });
-                        processMutex.unlock();
-                        return;
-                    }
-                    // load the audio file again
-                    DBG("ProcessID " + jobProcessID + " succeed");
-                    currentProcessID = "";
-                    model->setStatus(ModelStatus::FINISHED);
-                    processBroadcaster.sendChangeMessage();
-                    processMutex.unlock();
-                },
-                processID),
-            true);
-        DBG("NumJobs: " + std::to_string(jobProcessorThread.getNumJobs()));
-        DBG("NumThrds: " + std::to_string(jobProcessorThread.getNumThreads()));
+                        if (safeThis != nullptr)
+                        {
+                            safeThis->handleProcessingResult(jobProcessID, processingResult);
+                        }
+                    });
+            });
+    }
+
+    void handleProcessingResult(const String& jobProcessID, const OpResult& processingResult)
+    {
+        processMutex.lock();
+        if (jobProcessID != currentProcessID)
+        {
+            DBG("ProcessID " + jobProcessID + " not found");
+            processMutex.unlock();
+            return;
+        }
+        if (processingResult.failed())
+        {
+            Error processingError = processingResult.getError();
+            Error::fillUserMessage(processingError);
+            LogAndDBG("Error in Processing:\n" + processingError.devMessage.toStdString(),
+                      LogLevel::Error);
+            AlertWindow::showMessageBoxAsync(
+                AlertWindow::WarningIcon,
+                "Processing Error",
+                "An error occurred while processing the audio file: \n"
+                    + processingError.userMessage);
+            // Reset the process/cancel button back to the process mode
+            resetProcessingButtons();
+            processMutex.unlock();
+            return;
+        }
+        // load the audio file again
+        DBG("ProcessID " + jobProcessID + " succeed");
+        currentProcessID = "";
+        model->setStatus(ModelStatus::FINISHED);
+        processBroadcaster.sendChangeMessage();
+        processMutex.unlock();
     }
 
     /*
@@ -1297,6 +1376,12 @@ public:
     void paint(Graphics& g) override
     {
         g.fillAll(getUIColourIfAvailable(LookAndFeel_V4::ColourScheme::UIColour::windowBackground));
+
+        // First paint of the first window marks the end of startup
+        if (! StartupProfiler::getInstance()->isFinished())
+        {
+            StartupProfiler::getInstance()->finish();
+        }
     }
 
     void resized() override
@@ -1460,8 +1545,6 @@ private:
     // MenuBar
     std::unique_ptr<MenuBarComponent> menuBar;
 
-    std::unique_ptr<ModelStatusTimer> mModelStatusTimer { nullptr };
-
     ComboBox modelPathComboBox;
     std::string customPath;
     // Two usefull variables to keep track of the selected item in the modelPathComboBox
@@ -1539,15 +1622,11 @@ private:
     String currentProcessID;
     std::mutex processMutex;
 
-    /// CustomThreadPoolJob
-    // This one is used for Loading the models
-    // The thread pull for Processing lives inside the JobProcessorThread
-    ThreadPool threadPool { 1 };
-    // int jobsFinished;
-    // int totalJobs;
-    // JobProcessorThread jobProcessorThread;
-    ThreadPool jobProcessorThread { 10 };
-    std::deque<CustomThreadPoolJob*> customJobs;
+    // Runs model loading and processing, along with all other background work
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    // Every load and process submitted and not yet found finished, as each refers to this
+    std::vector<std::shared_ptr<TaskScheduler::TaskHandle>> pendingTasks;
 
     ChangeBroadcaster loadBroadcaster;
     ChangeBroadcaster processBroadcaster;
@@ -1634,7 +1713,8 @@ private:
             for (size_t i = 0; i < outputMediaDisplays.size(); ++i)
             {
                 URL tempFile = outputProcessedPaths[i];
-                outputMediaDisplays[i]->initializeDisplay(tempFile);
+                // Kept as a new step of the track's history, so it can be undone
+                outputMediaDisplays[i]->addNewTempFile(tempFile);
                 outputMediaDisplays[i]->addLabels(labels);
             }
             // URL tempFilePath = outputProcessedPaths[0];
@@ -1645,15 +1725,6 @@ private:
             return;
         }
 
-        if (source == mModelStatusTimer.get())
-        {
-            // update the status label
-            DBG("HARPProcessorEditor::changeListenerCallback: updating status label");
-            // statusLabel.setText(model->getStatus(), dontSendNotification);
-            setStatus(model->getStatus());
-            return;
-        }
-
         DBG("HARPProcessorEditor::changeListenerCallback: unhandled change broadcaster");
         return;
     }
@@ -1678,7 +1749,6 @@ private:
         {
             setModelCard(model->card());
             controlAreaWidget.setModel(model);
-            mModelStatusTimer->setModel(model);
             controlAreaWidget.populateControls();
 
             populateTracks();
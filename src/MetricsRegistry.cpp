@@ -0,0 +1,285 @@
+#include "MetricsRegistry.h"
+
+JUCE_IMPLEMENT_SINGLETON(MetricsRegistry)
+
+namespace
+{
+void atomicAdd(std::atomic<double>& target, double amount)
+{
+    double current = target.load(std::memory_order_relaxed);
+
+    while (! target.compare_exchange_weak(current, current + amount, std::memory_order_relaxed))
+    {
+    }
+}
+} // namespace
+
+void MetricsRegistry::Gauge::add(double amount) { atomicAdd(value, amount); }
+
+MetricsRegistry::Histogram::Histogram(std::vector<double> upperBounds)
+    : bounds(std::move(upperBounds)),
+      bucketCounts(std::make_unique<std::atomic<int64>[]>(bounds.size() + 1))
+{
+    std::sort(bounds.begin(), bounds.end());
+
+    for (size_t i = 0; i <= bounds.size(); ++i)
+    {
+        bucketCounts[i].store(0);
+    }
+}
+
+void MetricsRegistry::Histogram::observe(double value)
+{
+    size_t bucketIdx = static_cast<size_t>(
+        std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin());
+
+    bucketCounts[bucketIdx].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    atomicAdd(sum, value);
+}
+
+MetricsRegistry::MetricsRegistry() : Thread("HARP Metrics Exporter") {}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    // Exporter writes the final values before exiting
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+
+    clearSingletonInstance();
+}
+
+void MetricsRegistry::addCollector(Collector* collector)
+{
+    const ScopedLock sl(collectorsLock);
+
+    collectors.addIfNotAlreadyThere(collector);
+}
+
+void MetricsRegistry::removeCollector(Collector* collector)
+{
+    const ScopedLock sl(collectorsLock);
+
+    collectors.removeFirstMatchingValue(collector);
+}
+
+MetricsRegistry::Counter&
+    MetricsRegistry::getCounter(const String& name, const String& help, const StringPairArray& labels)
+{
+    const ScopedLock sl(familiesLock);
+
+    auto& counter = getFamily(name, help, Type::Counter).counters[formatLabels(labels)];
+
+    if (counter == nullptr)
+    {
+        counter = std::make_unique<Counter>();
+    }
+
+    return *counter;
+}
+
+MetricsRegistry::Gauge&
+    MetricsRegistry::getGauge(const String& name, const String& help, const StringPairArray& labels)
+{
+    const ScopedLock sl(familiesLock);
+
+    auto& gauge = getFamily(name, help, Type::Gauge).gauges[formatLabels(labels)];
+
+    if (gauge == nullptr)
+    {
+        gauge = std::make_unique<Gauge>();
+    }
+
+    return *gauge;
+}
+
+MetricsRegistry::Histogram& MetricsRegistry::getHistogram(const String& name,
+                                                          const String& help,
+                                                          const StringPairArray& labels,
+                                                          const std::vector<double>& upperBounds)
+{
+    const ScopedLock sl(familiesLock);
+
+    auto& histogram = getFamily(name, help, Type::Histogram).histograms[formatLabels(labels)];
+
+    if (histogram == nullptr)
+    {
+        histogram = std::make_unique<Histogram>(upperBounds);
+    }
+
+    return *histogram;
+}
+
+std::vector<double> MetricsRegistry::getDefaultLatencyBounds()
+{
+    return { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0, 300.0 };
+}
+
+void MetricsRegistry::startExporting(const File& directory)
+{
+    if (isThreadRunning())
+    {
+        return;
+    }
+
+    exportFile = directory.getChildFile("metrics.prom");
+
+    startThread(Thread::Priority::low);
+}
+
+String MetricsRegistry::toPrometheusText() const
+{
+    String text;
+
+    const ScopedLock sl(familiesLock);
+
+    for (const auto& [name, family] : families)
+    {
+        text << "# HELP " << name << " " << family.help << "\n";
+
+        switch (family.type)
+        {
+            case Type::Counter:
+                text << "# TYPE " << name << " counter\n";
+                break;
+            case Type::Gauge:
+                text << "# TYPE " << name << " gauge\n";
+                break;
+            case Type::Histogram:
+                text << "# TYPE " << name << " histogram\n";
+                break;
+        }
+
+        for (const auto& [labels, counter] : family.counters)
+        {
+            text << name << labels << " " << String(counter->get()) << "\n";
+        }
+
+        for (const auto& [labels, gauge] : family.gauges)
+        {
+            text << name << labels << " " << String(gauge->get()) << "\n";
+        }
+
+        for (const auto& [labels, histogram] : family.histograms)
+        {
+            const auto& bounds = histogram->getUpperBounds();
+
+            // Buckets are cumulative in the exposition format
+            int64 cumulativeCount = 0;
+
+            for (size_t i = 0; i <= bounds.size(); ++i)
+            {
+                cumulativeCount += histogram->getBucketCount(i);
+
+                String bound = i < bounds.size() ? String(bounds[i]) : String("+Inf");
+
+                text << name << "_bucket" << addLabel(labels, "le", bound) << " "
+                     << String(cumulativeCount) << "\n";
+            }
+
+            text << name << "_sum" << labels << " " << String(histogram->getSum()) << "\n";
+            text << name << "_count" << labels << " " << String(histogram->getCount()) << "\n";
+        }
+    }
+
+    return text;
+}
+
+void MetricsRegistry::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(exportIntervalMs);
+
+        collectSampledMetrics();
+
+        if (! exportToFile())
+        {
+            DBG("MetricsRegistry::run: Failed to write metrics to " << exportFile.getFullPathName()
+                                                                    << ".");
+        }
+    }
+
+    // Final values of the session
+    collectSampledMetrics();
+    exportToFile();
+}
+
+void MetricsRegistry::collectSampledMetrics()
+{
+    // Held throughout, so a collector cannot be removed (and deleted) while it is called
+    const ScopedLock sl(collectorsLock);
+
+    for (auto* collector : collectors)
+    {
+        collector->collectMetrics(*this);
+    }
+}
+
+bool MetricsRegistry::exportToFile() const
+{
+    // Written in full before replacing the old file, so a scraper never reads half of it
+    TemporaryFile tempFile(exportFile);
+
+    if (! tempFile.getFile().replaceWithText(toPrometheusText()))
+    {
+        return false;
+    }
+
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+MetricsRegistry::Family&
+    MetricsRegistry::getFamily(const String& name, const String& help, Type type)
+{
+    auto [it, inserted] = families.try_emplace(name);
+
+    if (inserted)
+    {
+        it->second.help = help;
+        it->second.type = type;
+    }
+
+    // Same name must always be registered as the same type of metric
+    jassert(it->second.type == type);
+
+    return it->second;
+}
+
+String MetricsRegistry::formatLabels(const StringPairArray& labels)
+{
+    if (labels.size() == 0)
+    {
+        return {};
+    }
+
+    StringArray pairs;
+
+    for (int i = 0; i < labels.size(); ++i)
+    {
+        String value = labels.getAllValues()[i]
+                           .replace("\\", "\\\\")
+                           .replace("\"", "\\\"")
+                           .replace("\n", "\\n");
+
+        pairs.add(labels.getAllKeys()[i] + "=\"" + value + "\"");
+    }
+
+    return "{" + pairs.joinIntoString(",") + "}";
+}
+
+String MetricsRegistry::addLabel(const String& formattedLabels,
+                                 const String& name,
+                                 const String& value)
+{
+    String label = name + "=\"" + value + "\"";
+
+    if (formattedLabels.isEmpty())
+    {
+        return "{" + label + "}";
+    }
+
+    return formattedLabels.dropLastCharacters(1) + "," + label + "}";
+}
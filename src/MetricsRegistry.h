@@ -0,0 +1,180 @@
+/**
+ * @file MetricsRegistry.h
+ * @brief Process-wide counters, gauges and histograms, exported for scraping
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace juce;
+
+/*
+  Aggregate numbers over a session (request counts, latencies, cache hit
+  rates, etc.), as opposed to the per-request timelines of TraceRecorder.
+
+  Subsystems look up a metric once by name and labels, which takes a lock,
+  and then update it through the returned reference, which never does.
+  Metrics live as long as the registry, so references can be kept (e.g., in
+  a static local) for the whole session.
+
+  The registry is written periodically in the Prometheus text format to
+  metrics.prom in the log directory, where a textfile collector can pick it
+  up.
+
+  The registry is never recreated once deleted at shutdown. Code which may
+  run after that (e.g., destructors of components) must look it up with
+  getInstanceWithoutCreating() and skip its update if it is gone.
+*/
+class MetricsRegistry : private DeletedAtShutdown, private Thread
+{
+public:
+    JUCE_DECLARE_SINGLETON(MetricsRegistry, true)
+
+    ~MetricsRegistry() override;
+
+    class Counter
+    {
+    public:
+        void increment(int64 amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+        int64 get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<int64> value { 0 };
+    };
+
+    class Gauge
+    {
+    public:
+        void set(double newValue) { value.store(newValue, std::memory_order_relaxed); }
+        void add(double amount);
+        double get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value { 0.0 };
+    };
+
+    class Histogram
+    {
+    public:
+        explicit Histogram(std::vector<double> upperBounds);
+
+        void observe(double value);
+
+        const std::vector<double>& getUpperBounds() const { return bounds; }
+
+        // Observations up to each bound (non-cumulative), with one extra for +Inf
+        int64 getBucketCount(size_t bucketIdx) const { return bucketCounts[bucketIdx].load(); }
+        int64 getCount() const { return count.load(); }
+        double getSum() const { return sum.load(); }
+
+    private:
+        std::vector<double> bounds;
+        std::unique_ptr<std::atomic<int64>[]> bucketCounts;
+
+        std::atomic<int64> count { 0 };
+        std::atomic<double> sum { 0.0 };
+    };
+
+    // Records the seconds between its construction and destruction into a histogram
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& h) : histogram(h), startTicks(Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            histogram.observe(
+                Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks));
+        }
+
+    private:
+        Histogram& histogram;
+        int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+    /*
+      Source of metrics which are sampled rather than updated as they change
+      (e.g., queue depths). Collectors are called on the exporter thread
+      before each export, and must be removed before they are deleted.
+    */
+    class Collector
+    {
+    public:
+        virtual ~Collector() = default;
+
+        virtual void collectMetrics(MetricsRegistry& registry) = 0;
+    };
+
+    void addCollector(Collector* collector);
+
+    // Waits for a collection in progress, so the collector can be deleted afterwards
+    void removeCollector(Collector* collector);
+
+    Counter& getCounter(const String& name, const String& help, const StringPairArray& labels = {});
+    Gauge& getGauge(const String& name, const String& help, const StringPairArray& labels = {});
+    Histogram& getHistogram(const String& name,
+                            const String& help,
+                            const StringPairArray& labels = {},
+                            const std::vector<double>& upperBounds = getDefaultLatencyBounds());
+
+    // Bounds (in seconds) from 5 ms up to 5 minutes
+    static std::vector<double> getDefaultLatencyBounds();
+
+    // Starts writing the registry to the directory every few seconds (and on shutdown)
+    void startExporting(const File& directory);
+
+    String toPrometheusText() const;
+
+private:
+    MetricsRegistry();
+
+    void run() override;
+
+    void collectSampledMetrics();
+
+    bool exportToFile() const;
+
+    enum class Type
+    {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    struct Family
+    {
+        String help;
+        Type type = Type::Counter;
+
+        // By formatted label set, e.g. {space="foo",phase="upload"}
+        std::map<String, std::unique_ptr<Counter>> counters;
+        std::map<String, std::unique_ptr<Gauge>> gauges;
+        std::map<String, std::unique_ptr<Histogram>> histograms;
+    };
+
+    Family& getFamily(const String& name, const String& help, Type type);
+
+    static String formatLabels(const StringPairArray& labels);
+    static String addLabel(const String& formattedLabels, const String& name, const String& value);
+
+    static constexpr int exportIntervalMs = 15000;
+
+    std::map<String, Family> families;
+    CriticalSection familiesLock;
+
+    Array<Collector*> collectors;
+    CriticalSection collectorsLock;
+
+    File exportFile;
+};
@@ -9,10 +9,12 @@
 #pragma once
 
 #include <any>
+#include <atomic>
 #include <map>
 #include <string>
 #include <unordered_map>
 
+#include "ModelStatusChannel.h"
 #include "errors.h"
 #include "juce_audio_basics/juce_audio_basics.h"
 #include "juce_events/juce_events.h"
@@ -65,8 +67,23 @@ public:
     // //! provides access to the model card (metadata)
     ModelCard& card() { return m_card; }
 
+    // Status may be read and set from any thread
+    ModelStatus getStatus() const { return status2.load(std::memory_order_acquire); }
+
+    void setStatus(ModelStatus status)
+    {
+        status2.store(status, std::memory_order_release);
+        statusChannel.publish(status);
+    }
+
+    // Delivers every status transition to the message thread
+    ModelStatusChannel& getStatusChannel() { return statusChannel; }
+
 protected:
     ModelCard m_card;
     bool m_loaded { false };
-    ModelStatus status2;
+    std::atomic<ModelStatus> status2 { ModelStatus::INITIALIZED };
+
+private:
+    ModelStatusChannel statusChannel;
 };
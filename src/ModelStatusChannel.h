@@ -0,0 +1,172 @@
+/**
+ * @file ModelStatusChannel.h
+ * @brief Lock-free delivery of model status transitions to the message thread
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+
+#include "juce_events/juce_events.h"
+#include "utils.h"
+
+using namespace juce;
+
+struct ModelStatusUpdate
+{
+    ModelStatus status = ModelStatus::INITIALIZED;
+
+    // Time of the transition (see Time::getMillisecondCounterHiRes)
+    double timeInMs = 0.0;
+};
+
+/*
+  Status transitions are published from whichever thread makes them (e.g.,
+  the job thread while processing) into a bounded multi-producer queue, and
+  delivered in order on the message thread. Publishing never blocks or
+  allocates, and any number of transitions between two message loop
+  iterations are delivered through a single coalesced async callback, so
+  short-lived states (e.g., SENDING before PROCESSING) are not lost.
+
+  If the queue fills up before the message thread gets to it, the oldest
+  undelivered transitions are kept and the latest status is delivered last.
+*/
+class ModelStatusChannel : private AsyncUpdater
+{
+public:
+    ModelStatusChannel()
+    {
+        for (size_t i = 0; i < capacity; ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~ModelStatusChannel() override { cancelPendingUpdate(); }
+
+    // Called on the message thread for every transition, in order
+    std::function<void(const ModelStatusUpdate&)> onStatusChanged;
+
+    // Safe to call from any thread
+    void publish(ModelStatus status)
+    {
+        latestStatus.store(status, std::memory_order_release);
+
+        ModelStatusUpdate update { status, Time::getMillisecondCounterHiRes() };
+
+        if (! push(update))
+        {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        triggerAsyncUpdate();
+    }
+
+private:
+    void handleAsyncUpdate() override
+    {
+        ModelStatusUpdate update;
+        bool delivered = false;
+
+        while (pop(update))
+        {
+            if (onStatusChanged)
+            {
+                onStatusChanged(update);
+            }
+
+            delivered = true;
+        }
+
+        if (int dropped = numDropped.exchange(0, std::memory_order_relaxed); dropped > 0)
+        {
+            DBG("ModelStatusChannel::handleAsyncUpdate: Dropped " << dropped
+                                                                  << " status transitions.");
+
+            // Make sure the final state is not among the dropped transitions
+            if (delivered && update.status != latestStatus.load(std::memory_order_acquire)
+                && onStatusChanged)
+            {
+                onStatusChanged(
+                    { latestStatus.load(std::memory_order_acquire), Time::getMillisecondCounterHiRes() });
+            }
+        }
+    }
+
+    // Bounded MPSC queue, where each cell's sequence number tells producers and
+    // the consumer whose turn it is to use the cell
+    bool push(const ModelStatusUpdate& update)
+    {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Cell& cell = cells[pos & (capacity - 1)];
+
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.update = update;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                // Full
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only called on the message thread
+    bool pop(ModelStatusUpdate& update)
+    {
+        Cell& cell = cells[dequeuePos & (capacity - 1)];
+
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+
+        if (static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(dequeuePos + 1) < 0)
+        {
+            // Empty
+            return false;
+        }
+
+        update = cell.update;
+        cell.sequence.store(dequeuePos + capacity, std::memory_order_release);
+
+        ++dequeuePos;
+
+        return true;
+    }
+
+    // Must be a power of two
+    static constexpr size_t capacity = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence { 0 };
+        ModelStatusUpdate update;
+    };
+
+    std::array<Cell, capacity> cells;
+
+    std::atomic<size_t> enqueuePos { 0 };
+    size_t dequeuePos = 0;
+
+    std::atomic<ModelStatus> latestStatus { ModelStatus::INITIALIZED };
+    std::atomic<int> numDropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModelStatusChannel)
+};
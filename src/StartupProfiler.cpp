@@ -0,0 +1,58 @@
+#include "StartupProfiler.h"
+
+#include "HarpLogger.h"
+#include "MetricsRegistry.h"
+
+JUCE_IMPLEMENT_SINGLETON(StartupProfiler)
+
+StartupProfiler::StartupProfiler() : startMs(Time::getMillisecondCounterHiRes()) {}
+
+StartupProfiler::~StartupProfiler() { clearSingletonInstance(); }
+
+void StartupProfiler::begin() { startMs = Time::getMillisecondCounterHiRes(); }
+
+void StartupProfiler::addPhase(const String& name, double phaseStartMs, double phaseEndMs)
+{
+    if (isFinished())
+    {
+        return;
+    }
+
+    const ScopedLock sl(phasesLock);
+
+    phases.add({ name, phaseStartMs, phaseEndMs });
+}
+
+void StartupProfiler::finish()
+{
+    if (finished.exchange(true))
+    {
+        return;
+    }
+
+    double totalMs = getElapsedMs();
+
+    String report = "Startup took " + String(totalMs, 1) + " ms until the first paint:";
+
+    {
+        const ScopedLock sl(phasesLock);
+
+        // Nested phases end before the phases containing them, so order by start time
+        std::sort(phases.begin(),
+                  phases.end(),
+                  [](const Phase& a, const Phase& b) { return a.startMs < b.startMs; });
+
+        for (const auto& phase : phases)
+        {
+            report << newLine << "  " << phase.name.paddedRight(' ', 20)
+                   << String(phase.endMs - phase.startMs, 1).paddedLeft(' ', 8) << " ms (at "
+                   << String(phase.startMs, 1) << " ms)";
+        }
+    }
+
+    LogAndDBG(report);
+
+    MetricsRegistry::getInstance()
+        ->getGauge("harp_startup_seconds", "Time from launch until the first window was painted.")
+        .set(totalMs / 1000.0);
+}
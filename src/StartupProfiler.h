@@ -0,0 +1,87 @@
+/**
+ * @file StartupProfiler.h
+ * @brief Timing report of the phases of application startup
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include "TraceRecorder.h"
+
+using namespace juce;
+
+/*
+  Measures how long each phase of startup takes, from the construction of
+  the application until the first window is painted. The report is written
+  to the log once, and the phases also show up as spans when tracing.
+
+  Phases recorded after the report (e.g., while opening another window) are
+  ignored.
+*/
+class StartupProfiler : private DeletedAtShutdown
+{
+public:
+    JUCE_DECLARE_SINGLETON(StartupProfiler, false)
+
+    ~StartupProfiler();
+
+    // Marks the start of startup, as early as possible in the application
+    void begin();
+
+    void addPhase(const String& name, double startMs, double endMs);
+
+    // Logs the report, once the first window is up
+    void finish();
+
+    bool isFinished() const { return finished.load(); }
+
+    // Milliseconds since begin()
+    double getElapsedMs() const { return Time::getMillisecondCounterHiRes() - startMs; }
+
+    // Records the time between its construction and destruction as a phase of startup
+    class ScopedPhase
+    {
+    public:
+        explicit ScopedPhase(const char* phaseName)
+            : name(phaseName),
+              span("startup", phaseName),
+              phaseStartMs(StartupProfiler::getInstance()->getElapsedMs())
+        {
+        }
+
+        ~ScopedPhase()
+        {
+            auto* profiler = StartupProfiler::getInstance();
+            profiler->addPhase(name, phaseStartMs, profiler->getElapsedMs());
+        }
+
+    private:
+        const char* name;
+        TraceSpan span;
+        double phaseStartMs;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedPhase)
+    };
+
+private:
+    StartupProfiler();
+
+    struct Phase
+    {
+        String name;
+        double startMs;
+        double endMs;
+    };
+
+    double startMs;
+    std::atomic<bool> finished { false };
+
+    CriticalSection phasesLock;
+    Array<Phase> phases;
+};
+
+// Records the rest of the enclosing scope as a phase of startup
+#define HARP_STARTUP_PHASE(name) \
+    StartupProfiler::ScopedPhase JUCE_JOIN_MACRO(startupPhase_, __LINE__)(name)
@@ -0,0 +1,411 @@
+#include "TaskScheduler.h"
+
+namespace
+{
+// Set on worker threads while they run a task
+thread_local TaskScheduler::TaskHandle* currentTaskHandle = nullptr;
+
+// Index of the compute worker owning the calling thread, or -1
+thread_local int currentComputeWorkerIdx = -1;
+} // namespace
+
+class TaskScheduler::Worker : public Thread
+{
+public:
+    Worker(TaskScheduler& s, const String& name, int idx, bool isCompute)
+        : Thread(name), scheduler(s), workerIdx(idx), isComputeWorker(isCompute)
+    {
+    }
+
+    void run() override
+    {
+        if (isComputeWorker)
+        {
+            currentComputeWorkerIdx = workerIdx;
+        }
+
+        while (! threadShouldExit() && ! scheduler.shuttingDown)
+        {
+            Task task;
+
+            bool found = isComputeWorker ? scheduler.findComputeTask(workerIdx, task)
+                                         : scheduler.findNetworkTask(task);
+
+            if (found)
+            {
+                scheduler.runTask(task);
+            }
+            else
+            {
+                scheduler.waitForWork(*this);
+            }
+        }
+    }
+
+    TaskScheduler& scheduler;
+
+    const int workerIdx;
+    const bool isComputeWorker;
+};
+
+bool TaskScheduler::TaskQueues::pop(Lane lane, Task& task)
+{
+    std::lock_guard<std::mutex> sl(lock);
+
+    auto& queue = tasks[static_cast<size_t>(lane)];
+
+    if (queue.empty())
+    {
+        return false;
+    }
+
+    task = std::move(queue.front());
+    queue.pop_front();
+
+    return true;
+}
+
+TaskScheduler::TaskScheduler()
+{
+    int numComputeThreads = jmax(2, SystemStats::getNumCpus());
+
+    for (int i = 0; i < numComputeThreads; ++i)
+    {
+        computeQueues.add(new TaskQueues());
+        computeWorkers.add(new Worker(*this, "Task Worker " + String(i), i, true));
+    }
+
+    for (int i = 0; i < numNetworkThreads; ++i)
+    {
+        networkWorkers.add(new Worker(*this, "Network Worker " + String(i), i, false));
+    }
+
+    for (auto* worker : computeWorkers)
+    {
+        worker->startThread();
+    }
+
+    for (auto* worker : networkWorkers)
+    {
+        worker->startThread();
+    }
+
+    if (auto* metrics = MetricsRegistry::getInstance())
+    {
+        metrics->addCollector(this);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    // The registry may already be gone at shutdown
+    if (auto* metrics = MetricsRegistry::getInstanceWithoutCreating())
+    {
+        metrics->removeCollector(this);
+    }
+
+    shuttingDown = true;
+
+    for (auto* worker : computeWorkers)
+    {
+        worker->signalThreadShouldExit();
+    }
+
+    for (auto* worker : networkWorkers)
+    {
+        worker->signalThreadShouldExit();
+    }
+
+    {
+        std::lock_guard<std::mutex> sl(sleepLock);
+
+        computeWorkAvailable.notify_all();
+        networkWorkAvailable.notify_all();
+    }
+
+    // Running tasks are given time to finish
+    for (auto* worker : computeWorkers)
+    {
+        worker->stopThread(5000);
+    }
+
+    for (auto* worker : networkWorkers)
+    {
+        worker->stopThread(5000);
+    }
+
+    // Tasks which never started are skipped, so nobody waits on them forever
+    auto skipQueuedTasks = [this](TaskQueues& queues)
+    {
+        for (Lane lane : { Lane::Interactive, Lane::Network, Lane::Background })
+        {
+            Task task;
+
+            while (queues.pop(lane, task))
+            {
+                --getCounters(lane).numQueued;
+
+                task.handle->cancel();
+                runTask(task);
+            }
+        }
+    };
+
+    for (auto* queues : computeQueues)
+    {
+        skipQueuedTasks(*queues);
+    }
+
+    skipQueuedTasks(networkQueues);
+}
+
+std::shared_ptr<TaskScheduler::TaskHandle> TaskScheduler::submit(Lane lane,
+                                                                 std::function<void()> task)
+{
+    auto handle = std::make_shared<TaskHandle>();
+
+    Task newTask;
+    newTask.function = std::move(task);
+    newTask.handle = handle;
+    newTask.lane = lane;
+    newTask.submitTimeMs = Time::getMillisecondCounterHiRes();
+
+    TaskQueues* queues = &networkQueues;
+
+    if (lane != Lane::Network)
+    {
+        // Work spawned by a worker stays with it, where its data is likely still in cache
+        int workerIdx = currentComputeWorkerIdx;
+
+        if (workerIdx < 0)
+        {
+            workerIdx = static_cast<int>(nextWorkerIdx++ % static_cast<uint32>(computeQueues.size()));
+        }
+
+        queues = computeQueues[workerIdx];
+    }
+
+    {
+        // Counted before the task is published, so a worker popping it never takes the
+        // count below zero, and under the sleep lock, so a worker about to sleep cannot miss it
+        std::lock_guard<std::mutex> sl(sleepLock);
+
+        ++getCounters(lane).numQueued;
+    }
+
+    {
+        std::lock_guard<std::mutex> sl(queues->lock);
+
+        queues->tasks[static_cast<size_t>(lane)].push_back(std::move(newTask));
+    }
+
+    if (lane == Lane::Network)
+    {
+        networkWorkAvailable.notify_one();
+    }
+    else
+    {
+        computeWorkAvailable.notify_one();
+    }
+
+    return handle;
+}
+
+bool TaskScheduler::isCurrentTaskCancelled()
+{
+    return currentTaskHandle != nullptr && currentTaskHandle->isCancelled();
+}
+
+TaskScheduler::Stats TaskScheduler::getStats() const
+{
+    Stats stats;
+
+    stats.numComputeThreads = computeWorkers.size();
+    stats.numNetworkThreads = networkWorkers.size();
+
+    for (size_t i = 0; i < static_cast<size_t>(numLanes); ++i)
+    {
+        const LaneCounters& counters = laneCounters[i];
+        LaneStats& laneStats = stats.lanes[i];
+
+        laneStats.numQueued = counters.numQueued.load();
+        laneStats.numRunning = counters.numRunning.load();
+        laneStats.numCompleted = counters.numCompleted.load();
+        laneStats.numCancelled = counters.numCancelled.load();
+
+        int64 numStarted = laneStats.numCompleted + laneStats.numRunning;
+
+        laneStats.meanLatencyMs =
+            numStarted > 0 ? static_cast<double>(counters.totalLatencyUs.load())
+                                 / static_cast<double>(numStarted) / 1000.0
+                           : 0.0;
+        laneStats.maxLatencyMs = static_cast<double>(counters.maxLatencyUs.load()) / 1000.0;
+    }
+
+    return stats;
+}
+
+void TaskScheduler::collectMetrics(MetricsRegistry& registry)
+{
+    Stats stats = getStats();
+
+    auto setNumThreads = [&registry](const String& pool, int numThreads)
+    {
+        StringPairArray labels;
+        labels.set("pool", pool);
+
+        registry.getGauge("harp_scheduler_threads", "Worker threads of the task scheduler.", labels)
+            .set(static_cast<double>(numThreads));
+    };
+
+    setNumThreads("compute", stats.numComputeThreads);
+    setNumThreads("network", stats.numNetworkThreads);
+
+    for (Lane lane : { Lane::Interactive, Lane::Network, Lane::Background })
+    {
+        const LaneStats& laneStats = stats.lanes[static_cast<size_t>(lane)];
+
+        StringPairArray labels;
+        labels.set("lane", getLaneName(lane));
+
+        registry
+            .getGauge("harp_scheduler_queued_tasks", "Tasks waiting to start, by lane.", labels)
+            .set(static_cast<double>(laneStats.numQueued));
+        registry
+            .getGauge("harp_scheduler_running_tasks", "Tasks currently running, by lane.", labels)
+            .set(static_cast<double>(laneStats.numRunning));
+        registry
+            .getGauge("harp_scheduler_completed_tasks",
+                      "Tasks run to completion this session, by lane.",
+                      labels)
+            .set(static_cast<double>(laneStats.numCompleted));
+        registry
+            .getGauge("harp_scheduler_cancelled_tasks",
+                      "Tasks skipped after being cancelled this session, by lane.",
+                      labels)
+            .set(static_cast<double>(laneStats.numCancelled));
+        registry
+            .getGauge("harp_scheduler_mean_latency_seconds",
+                      "Mean time tasks spent queued before they started, by lane.",
+                      labels)
+            .set(laneStats.meanLatencyMs / 1000.0);
+        registry
+            .getGauge("harp_scheduler_max_latency_seconds",
+                      "Longest time a task spent queued before it started, by lane.",
+                      labels)
+            .set(laneStats.maxLatencyMs / 1000.0);
+    }
+}
+
+String TaskScheduler::getLaneName(Lane lane)
+{
+    switch (lane)
+    {
+        case Lane::Interactive:
+            return "interactive";
+        case Lane::Network:
+            return "network";
+        case Lane::Background:
+            return "background";
+    }
+
+    return {};
+}
+
+bool TaskScheduler::findComputeTask(int workerIdx, Task& task)
+{
+    int numWorkers = computeQueues.size();
+
+    for (Lane lane : { Lane::Interactive, Lane::Background })
+    {
+        // Own queue first, then steal from the others
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            if (computeQueues[(workerIdx + i) % numWorkers]->pop(lane, task))
+            {
+                --getCounters(lane).numQueued;
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool TaskScheduler::findNetworkTask(Task& task)
+{
+    if (networkQueues.pop(Lane::Network, task))
+    {
+        --getCounters(Lane::Network).numQueued;
+
+        return true;
+    }
+
+    return false;
+}
+
+void TaskScheduler::runTask(Task& task)
+{
+    LaneCounters& counters = getCounters(task.lane);
+
+    if (task.handle->isCancelled())
+    {
+        ++counters.numCancelled;
+    }
+    else
+    {
+        auto latencyUs = static_cast<int64>(
+            (Time::getMillisecondCounterHiRes() - task.submitTimeMs) * 1000.0);
+
+        counters.totalLatencyUs += latencyUs;
+
+        int64 maxLatencyUs = counters.maxLatencyUs.load();
+
+        while (latencyUs > maxLatencyUs
+               && ! counters.maxLatencyUs.compare_exchange_weak(maxLatencyUs, latencyUs))
+        {
+        }
+
+        ++counters.numRunning;
+
+        currentTaskHandle = task.handle.get();
+        task.function();
+        currentTaskHandle = nullptr;
+
+        --counters.numRunning;
+        ++counters.numCompleted;
+    }
+
+    // Release whatever the task captured before anyone waiting is woken up
+    task.function = nullptr;
+
+    task.handle->finished = true;
+    task.handle->finishedEvent.signal();
+}
+
+void TaskScheduler::waitForWork(Worker& worker)
+{
+    std::unique_lock<std::mutex> sl(sleepLock);
+
+    auto hasWork = [this, &worker]
+    {
+        if (shuttingDown)
+        {
+            return true;
+        }
+
+        if (worker.isComputeWorker)
+        {
+            return getCounters(Lane::Interactive).numQueued > 0
+                   || getCounters(Lane::Background).numQueued > 0;
+        }
+
+        return getCounters(Lane::Network).numQueued > 0;
+    };
+
+    auto& workAvailable = worker.isComputeWorker ? computeWorkAvailable : networkWorkAvailable;
+
+    // Every submission notifies after counting its task, so idle workers sleep until then
+    workAvailable.wait(sl, hasWork);
+}
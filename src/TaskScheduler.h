@@ -0,0 +1,172 @@
+/**
+ * @file TaskScheduler.h
+ * @brief Application-wide scheduler for background work, with priority lanes
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "MetricsRegistry.h"
+
+using namespace juce;
+
+/*
+  All background work of the application goes through this scheduler, which
+  is meant to be held through a SharedResourcePointer. Work is submitted to
+  one of three lanes:
+
+  - Interactive: work the UI is waiting on (e.g., loading a file into a display)
+  - Network: requests which mostly wait on a server (e.g., loading a model)
+  - Background: work nobody is waiting on (e.g., decoding files for the cache)
+
+  Interactive and background tasks run on compute workers (one per core).
+  Each worker has its own queue per lane and steals from the others when its
+  own queues are empty, always preferring interactive work. Network tasks run
+  on a separate set of threads, so waiting on a server never holds up a core.
+
+  Tasks which have not started yet can be cancelled through their handle.
+  Running tasks can poll TaskScheduler::isCurrentTaskCancelled() to stop early.
+
+  The number of threads, and the depth and latency of each lane, are sampled
+  into the MetricsRegistry before each export.
+*/
+class TaskScheduler : private MetricsRegistry::Collector
+{
+public:
+    enum class Lane
+    {
+        Interactive,
+        Network,
+        Background
+    };
+
+    static constexpr int numLanes = 3;
+
+    class TaskHandle
+    {
+    public:
+        // Skips the task if it has not started, otherwise asks it to stop
+        void cancel() { cancelled = true; }
+        bool isCancelled() const { return cancelled.load(); }
+
+        // Whether the task ran to completion or was skipped
+        bool hasFinished() const { return finished.load(); }
+
+        // Returns false if the task is still running after the timeout (-1 waits forever)
+        bool waitForCompletion(int timeOutMilliseconds = -1) const
+        {
+            return finishedEvent.wait(timeOutMilliseconds);
+        }
+
+    private:
+        friend class TaskScheduler;
+
+        std::atomic<bool> cancelled { false };
+        std::atomic<bool> finished { false };
+
+        WaitableEvent finishedEvent { true };
+    };
+
+    struct LaneStats
+    {
+        int numQueued = 0;
+        int numRunning = 0;
+        int64 numCompleted = 0;
+        int64 numCancelled = 0;
+
+        // Time tasks spent queued before they started
+        double meanLatencyMs = 0.0;
+        double maxLatencyMs = 0.0;
+    };
+
+    struct Stats
+    {
+        int numComputeThreads = 0;
+        int numNetworkThreads = 0;
+
+        std::array<LaneStats, numLanes> lanes;
+    };
+
+    TaskScheduler();
+    ~TaskScheduler() override;
+
+    std::shared_ptr<TaskHandle> submit(Lane lane, std::function<void()> task);
+
+    // Whether the task running on the calling thread has been cancelled
+    static bool isCurrentTaskCancelled();
+
+    Stats getStats() const;
+
+private:
+    struct Task
+    {
+        std::function<void()> function;
+        std::shared_ptr<TaskHandle> handle;
+        Lane lane = Lane::Interactive;
+        double submitTimeMs = 0.0;
+    };
+
+    // Queues of a single worker (or of all network threads), by lane
+    struct TaskQueues
+    {
+        std::mutex lock;
+        std::array<std::deque<Task>, numLanes> tasks;
+
+        bool pop(Lane lane, Task& task);
+    };
+
+    class Worker;
+
+    void collectMetrics(MetricsRegistry& registry) override;
+
+    static String getLaneName(Lane lane);
+
+    bool findComputeTask(int workerIdx, Task& task);
+    bool findNetworkTask(Task& task);
+
+    void runTask(Task& task);
+
+    void waitForWork(Worker& worker);
+
+    struct LaneCounters
+    {
+        std::atomic<int> numQueued { 0 };
+        std::atomic<int> numRunning { 0 };
+        std::atomic<int64> numCompleted { 0 };
+        std::atomic<int64> numCancelled { 0 };
+        std::atomic<int64> totalLatencyUs { 0 };
+        std::atomic<int64> maxLatencyUs { 0 };
+    };
+
+    LaneCounters& getCounters(Lane lane) { return laneCounters[static_cast<size_t>(lane)]; }
+
+    // Network threads spend nearly all their time waiting, so there can be more than cores
+    static constexpr int numNetworkThreads = 8;
+
+    OwnedArray<Worker> computeWorkers;
+    OwnedArray<Worker> networkWorkers;
+
+    OwnedArray<TaskQueues> computeQueues;
+    TaskQueues networkQueues;
+
+    // Spreads tasks submitted from outside the compute workers
+    std::atomic<uint32> nextWorkerIdx { 0 };
+
+    std::mutex sleepLock;
+    std::condition_variable computeWorkAvailable;
+    std::condition_variable networkWorkAvailable;
+
+    std::atomic<bool> shuttingDown { false };
+
+    std::array<LaneCounters, numLanes> laneCounters;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TaskScheduler)
+};
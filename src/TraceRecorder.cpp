@@ -0,0 +1,163 @@
+#include "TraceRecorder.h"
+
+JUCE_IMPLEMENT_SINGLETON(TraceRecorder)
+
+std::atomic<bool> TraceRecorder::recording { false };
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+    clearSingletonInstance();
+}
+
+void TraceRecorder::start(const File& outputFile)
+{
+    if (isRecording())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> sl(buffersLock);
+
+        buffers.clear();
+    }
+
+    traceFile = outputFile;
+    startTicks = Time::getHighResolutionTicks();
+
+    ++session;
+    recording = true;
+
+    DBG("TraceRecorder::start: Recording trace to " << traceFile.getFullPathName() << ".");
+}
+
+void TraceRecorder::stop()
+{
+    if (! isRecording())
+    {
+        return;
+    }
+
+    recording = false;
+
+    if (! writeTrace(traceFile))
+    {
+        DBG("TraceRecorder::stop: Failed to write trace to " << traceFile.getFullPathName()
+                                                             << ".");
+    }
+}
+
+int64 TraceRecorder::getTimestamp() const
+{
+    return static_cast<int64>(
+        Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1.0e6);
+}
+
+void TraceRecorder::addCompleteEvent(const char* category,
+                                     const char* name,
+                                     int64 startUs,
+                                     int64 endUs)
+{
+    ThreadBuffer& buffer = getThreadBuffer();
+
+    std::lock_guard<std::mutex> sl(buffer.lock);
+
+    buffer.events.push_back({ category, name, startUs, endUs - startUs });
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::getThreadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+    thread_local int threadSession = 0;
+
+    int currentSession = session.load();
+
+    if (threadBuffer == nullptr || threadSession != currentSession)
+    {
+        threadBuffer = std::make_shared<ThreadBuffer>();
+        threadSession = currentSession;
+
+        threadBuffer->threadID = static_cast<uint64>(
+            reinterpret_cast<pointer_sized_uint>(Thread::getCurrentThreadId()));
+
+        if (MessageManager::getInstanceWithoutCreating() != nullptr
+            && MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread())
+        {
+            threadBuffer->threadName = "Message Thread";
+        }
+        else if (Thread* thread = Thread::getCurrentThread())
+        {
+            threadBuffer->threadName = thread->getThreadName();
+        }
+        else
+        {
+            threadBuffer->threadName = "Thread " + String(threadBuffer->threadID);
+        }
+
+        // Registry shares ownership, so events survive threads exiting
+        std::lock_guard<std::mutex> sl(buffersLock);
+
+        buffers.push_back(threadBuffer);
+    }
+
+    return *threadBuffer;
+}
+
+bool TraceRecorder::writeTrace(const File& file)
+{
+    FileOutputStream stream(file);
+
+    if (stream.failedToOpen())
+    {
+        return false;
+    }
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    const int processID = 1;
+
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool isFirstEvent = true;
+
+    auto writeSeparator = [&]
+    {
+        if (! isFirstEvent)
+        {
+            stream << ",";
+        }
+
+        stream << newLine;
+        isFirstEvent = false;
+    };
+
+    std::lock_guard<std::mutex> buffersSl(buffersLock);
+
+    for (const auto& buffer : buffers)
+    {
+        std::lock_guard<std::mutex> sl(buffer->lock);
+
+        // Name the thread's track in the viewer
+        writeSeparator();
+        stream << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << processID
+               << ",\"tid\":" << String(buffer->threadID)
+               << ",\"args\":{\"name\":" << JSON::toString(buffer->threadName) << "}}";
+
+        for (const Event& event : buffer->events)
+        {
+            writeSeparator();
+            stream << "{\"ph\":\"X\",\"cat\":\"" << event.category << "\",\"name\":\""
+                   << event.name << "\",\"pid\":" << processID
+                   << ",\"tid\":" << String(buffer->threadID) << ",\"ts\":" << event.startUs
+                   << ",\"dur\":" << event.durationUs << "}";
+        }
+    }
+
+    stream << newLine << "]}" << newLine;
+
+    stream.flush();
+
+    return stream.getStatus().wasOk();
+}
@@ -0,0 +1,118 @@
+/**
+ * @file TraceRecorder.h
+ * @brief Scoped trace spans, written out as Chrome / Perfetto trace-event JSON
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace juce;
+
+/*
+  Records how long scoped spans take on each thread, to see how a slow
+  process call is spread over network, model and UI work. Recording is
+  enabled with the "enableTracing" setting or the --trace command-line flag,
+  and the trace is written when the application quits. The resulting file
+  can be opened in chrome://tracing or ui.perfetto.dev.
+
+  When recording is off, a span costs a single relaxed atomic load.
+  Span names and categories must be string literals (or otherwise outlive
+  the recorder), since only the pointers are stored.
+*/
+class TraceRecorder : private DeletedAtShutdown
+{
+public:
+    JUCE_DECLARE_SINGLETON(TraceRecorder, false)
+
+    ~TraceRecorder();
+
+    void start(const File& outputFile);
+
+    // Writes everything recorded so far and stops recording
+    void stop();
+
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // Microseconds since recording started
+    int64 getTimestamp() const;
+
+    void addCompleteEvent(const char* category, const char* name, int64 startUs, int64 endUs);
+
+private:
+    TraceRecorder() = default;
+
+    struct Event
+    {
+        const char* category;
+        const char* name;
+        int64 startUs;
+        int64 durationUs;
+    };
+
+    // Events of a single thread, so recording never contends with other threads
+    struct ThreadBuffer
+    {
+        std::mutex lock;
+        std::vector<Event> events;
+
+        uint64 threadID = 0;
+        String threadName;
+    };
+
+    ThreadBuffer& getThreadBuffer();
+
+    bool writeTrace(const File& file);
+
+    static std::atomic<bool> recording;
+
+    int64 startTicks = 0;
+    File traceFile;
+
+    std::mutex buffersLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    // Identifies a recording session, so threads register a new buffer for each
+    std::atomic<int> session { 0 };
+};
+
+// Records the time between its construction and destruction as a trace event
+class TraceSpan
+{
+public:
+    TraceSpan(const char* spanCategory, const char* spanName)
+        : category(spanCategory), name(spanName)
+    {
+        if (TraceRecorder::isRecording())
+        {
+            startUs = TraceRecorder::getInstance()->getTimestamp();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (startUs >= 0 && TraceRecorder::isRecording())
+        {
+            auto* recorder = TraceRecorder::getInstance();
+            recorder->addCompleteEvent(category, name, startUs, recorder->getTimestamp());
+        }
+    }
+
+private:
+    const char* category;
+    const char* name;
+
+    int64 startUs = -1;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceSpan)
+};
+
+// Traces the rest of the enclosing scope
+#define HARP_TRACE_SCOPE(category, name) \
+    TraceSpan JUCE_JOIN_MACRO(traceSpan_, __LINE__)(category, name)
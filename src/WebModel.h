@@ -9,7 +9,9 @@
 #pragma once
 
 #include "HarpLogger.h"
+#include "MetricsRegistry.h"
 #include "Model.h"
+#include "TraceRecorder.h"
 #include "client/Client.h"
 #include "client/GradioClient.h"
 #include "client/StabilityClient.h"
@@ -20,7 +22,7 @@
 class WebModel : public Model
 {
 public:
-    WebModel() { status2 = ModelStatus::INITIALIZED; }
+    WebModel() {}
 
     ~WebModel() {}
 
@@ -247,13 +249,24 @@ public:
 
     OpResult load(const map<string, any>& params) override
     {
+        OpResult result = loadSpace(params);
+
+        recordOperation("load", std::any_cast<std::string>(params.at("url")), result);
+
+        return result;
+    }
+
+    OpResult loadSpace(const map<string, any>& params)
+    {
+        HARP_TRACE_SCOPE("model", "WebModel::load");
+
         // Create an Error object in case we need it
         // and a successful result
         Error error;
         error.type = ErrorType::JsonParseError;
         OpResult result = OpResult::ok();
 
-        status2 = ModelStatus::LOADING;
+        setStatus(ModelStatus::LOADING);
 
         std::string userSpaceAddress = std::any_cast<std::string>(params.at("url"));
 
@@ -261,7 +274,7 @@ public:
         result = parseSpaceAddress(userSpaceAddress, spaceInfo);
         if (result.failed())
         {
-            status2 = ModelStatus::ERROR;
+            setStatus(ModelStatus::ERROR);
             return result;
         }
 
@@ -289,11 +302,11 @@ public:
         juce::Array<juce::var> outputPyharpComponents;
 
         juce::DynamicObject cardDict;
-        status2 = ModelStatus::GETTING_CONTROLS;
+        setStatus(ModelStatus::GETTING_CONTROLS);
         result = tempClient->getControls(inputPyharpComponents, outputPyharpComponents, cardDict);
         if (result.failed())
         {
-            status2 = ModelStatus::ERROR;
+            setStatus(ModelStatus::ERROR);
             return result;
         }
 
@@ -307,7 +320,7 @@ public:
         juce::Array<juce::var>* tags = cardDict.getProperty("tags").getArray();
         if (tags == nullptr)
         {
-            status2 = ModelStatus::ERROR;
+            setStatus(ModelStatus::ERROR);
             error.devMessage = "Failed to load the tags array from JSON. tags is null.";
             return OpResult::fail(error);
         }
@@ -330,7 +343,7 @@ public:
             juce::var pyharpComponent = inputPyharpComponents.getReference(i);
             if (! pyharpComponent.isObject())
             {
-                status2 = ModelStatus::ERROR;
+                setStatus(ModelStatus::ERROR);
                 error.devMessage = "Failed to load controls from JSON. control is not an object.";
                 return OpResult::fail(error);
             }
@@ -349,7 +362,7 @@ public:
                     audio_in->required = stringToBool(pyharpComponent["required"].toString());
                     inputTracksInfo.push_back({ audio_in->id, audio_in });
                     uuidsInOrder.push_back(audio_in->id);
-                    LogAndDBG("Audio In: " + audio_in->label + " added");
+                    HARP_LOG(LogLevel::Debug, "Audio In: " + audio_in->label + " added");
                 }
                 else if (type == "midi_track")
                 {
@@ -360,7 +373,7 @@ public:
                     midi_in->required = stringToBool(pyharpComponent["required"].toString());
                     inputTracksInfo.push_back({ midi_in->id, midi_in });
                     uuidsInOrder.push_back(midi_in->id);
-                    LogAndDBG("MIDI In: " + midi_in->label + " added");
+                    HARP_LOG(LogLevel::Debug, "MIDI In: " + midi_in->label + " added");
                 }
                 else if (type == "slider")
                 {
@@ -375,7 +388,7 @@ public:
 
                     controlsInfo.push_back({ slider->id, slider });
                     uuidsInOrder.push_back(slider->id);
-                    LogAndDBG("Slider: " + slider->label + " added");
+                    HARP_LOG(LogLevel::Debug, "Slider: " + slider->label + " added");
                 }
                 else if (type == "text_box")
                 {
@@ -387,7 +400,7 @@ public:
 
                     controlsInfo.push_back({ text->id, text });
                     uuidsInOrder.push_back(text->id);
-                    LogAndDBG("Text: " + text->label + " added");
+                    HARP_LOG(LogLevel::Debug, "Text: " + text->label + " added");
                 }
                 else if (type == "number_box")
                 {
@@ -401,7 +414,7 @@ public:
 
                     controlsInfo.push_back({ number_box->id, number_box });
                     uuidsInOrder.push_back(number_box->id);
-                    LogAndDBG("Number Box: " + number_box->label + " added");
+                    HARP_LOG(LogLevel::Debug, "Number Box: " + number_box->label + " added");
                 }
                 else if (type == "toggle")
                 {
@@ -412,7 +425,7 @@ public:
                     toggle->value = ("1" == pyharpComponent["value"].toString().toStdString());
                     controlsInfo.push_back({ toggle->id, toggle });
                     uuidsInOrder.push_back(toggle->id);
-                    LogAndDBG("Toggle: " + toggle->label + " added");
+                    HARP_LOG(LogLevel::Debug, "Toggle: " + toggle->label + " added");
                 }
                 else if (type == "dropdown")
                 {
@@ -423,7 +436,7 @@ public:
                     juce::Array<juce::var>* choices = pyharpComponent["choices"].getArray();
                     if (choices == nullptr)
                     {
-                        status2 = ModelStatus::ERROR;
+                        setStatus(ModelStatus::ERROR);
                         error.devMessage = "Failed to load controls from JSON. options is null.";
                         return OpResult::fail(error);
                     }
@@ -439,7 +452,7 @@ public:
                     if (dropdown->options.empty())
                     {
                         // Don't fail here, just log a warning
-                        LogAndDBG("Dropdown control has no options.");
+                        LogAndDBG("Dropdown control has no options.", LogLevel::Warning);
                     }
                     else
                     {
@@ -459,11 +472,12 @@ public:
                     }
                 }
                 else
-                    LogAndDBG("failed to parse control with unknown type: " + type);
+                    LogAndDBG("failed to parse control with unknown type: " + type,
+                              LogLevel::Warning);
             }
             catch (const char* e)
             {
-                status2 = ModelStatus::ERROR;
+                setStatus(ModelStatus::ERROR);
                 error.devMessage = "Failed to load controls from JSON. " + std::string(e);
                 return OpResult::fail(error);
             }
@@ -475,7 +489,7 @@ public:
             juce::var pyharpComponent = outputPyharpComponents.getReference(i);
             if (! pyharpComponent.isObject())
             {
-                status2 = ModelStatus::ERROR;
+                setStatus(ModelStatus::ERROR);
                 error.devMessage = "Failed to load controls from JSON. control is not an object.";
                 return OpResult::fail(error);
             }
@@ -493,7 +507,7 @@ public:
                     audio_out->info = pyharpComponent["info"].toString().toStdString();
 
                     outputTracksInfo.push_back({ audio_out->id, audio_out });
-                    LogAndDBG("Audio Out: " + audio_out->label + " added");
+                    HARP_LOG(LogLevel::Debug, "Audio Out: " + audio_out->label + " added");
                 }
                 else if (type == "midi_track")
                 {
@@ -503,18 +517,18 @@ public:
                     midi_out->info = pyharpComponent["info"].toString().toStdString();
 
                     outputTracksInfo.push_back({ midi_out->id, midi_out });
-                    LogAndDBG("MIDI Out: " + midi_out->label + " added");
+                    HARP_LOG(LogLevel::Debug, "MIDI Out: " + midi_out->label + " added");
                 }
             }
             catch (const char* e)
             {
-                status2 = ModelStatus::ERROR;
+                setStatus(ModelStatus::ERROR);
                 error.devMessage = "Failed to load controls from JSON. " + std::string(e);
                 return OpResult::fail(error);
             }
         }
         loadedClient = std::move(tempClient);
-        status2 = ModelStatus::LOADED;
+        setStatus(ModelStatus::LOADED);
         m_loaded = true;
         return OpResult::ok();
     }
@@ -523,14 +537,25 @@ public:
     // the files currently loaded in each inputMediaDisplay
     OpResult process(std::vector<std::tuple<Uuid, String, File>> localInputTrackFiles)
     {
-        status2 = ModelStatus::STARTING;
+        OpResult result = processTracks(localInputTrackFiles);
+
+        recordOperation("process", loadedClient->getSpaceInfo().getModelSlashUser(), result);
+
+        return result;
+    }
+
+    OpResult processTracks(const std::vector<std::tuple<Uuid, String, File>>& localInputTrackFiles)
+    {
+        HARP_TRACE_SCOPE("model", "WebModel::process");
+
+        setStatus(ModelStatus::STARTING);
         // Create an Error object in case we need it
         // and a successful result
         Error error;
         error.type = ErrorType::JsonParseError;
         OpResult result = OpResult::ok();
 
-        status2 = ModelStatus::SENDING;
+        setStatus(ModelStatus::SENDING);
 
         // Clear the outputFilePaths and the labels
         // They will be populated with the new processing results
@@ -553,7 +578,7 @@ public:
                 result.getError().userMessage = "Failed to upload file for track "
                                                 + std::get<1>(tuple) + ": "
                                                 + std::get<2>(tuple).getFileName();
-                status2 = ModelStatus::ERROR;
+                setStatus(ModelStatus::ERROR);
                 return result;
             }
             // remoteTrackFilePaths[std::get<0>(tuple)] = remoteTrackFilePath.toStdString();
@@ -565,7 +590,7 @@ public:
             auto trackInfo = findComponentInfoByUuid(std::get<0>(tuple));
             if (trackInfo == nullptr)
             {
-                status2 = ModelStatus::ERROR;
+                setStatus(ModelStatus::ERROR);
                 error.devMessage = "Failed to upload file for track " + std::get<1>(tuple) + ": "
                                    + std::get<2>(tuple).getFileName()
                                    + ". The track is not an audio or midi track.";
@@ -587,18 +612,18 @@ public:
         if (result.failed())
         {
             result.getError().devMessage = "Failed to upload file";
-            status2 = ModelStatus::ERROR;
+            setStatus(ModelStatus::ERROR);
             return result;
         }
 
-        status2 = ModelStatus::PROCESSING;
+        setStatus(ModelStatus::PROCESSING);
         result = loadedClient->processRequest(error, processingPayload, outputFilePaths, labels);
         if (result.failed())
         {
-            status2 = ModelStatus::ERROR;
+            setStatus(ModelStatus::ERROR);
         }
         // Finished status will be set by the MainComponent.h
-        // status2 = ModelStatus::FINISHED;
+        // setStatus(ModelStatus::FINISHED);
         return result;
     }
 
@@ -606,21 +631,17 @@ public:
     {
         // Create a successful result.
         // we'll update it to a failure result if something goes wrong
-        status2 = ModelStatus::CANCELLING;
+        setStatus(ModelStatus::CANCELLING);
         OpResult result = loadedClient->cancel();
         if (result.failed())
         {
-            status2 = ModelStatus::ERROR;
+            setStatus(ModelStatus::ERROR);
             return result;
         }
-        status2 = ModelStatus::CANCELLED;
+        setStatus(ModelStatus::CANCELLED);
         return result;
     }
 
-    ModelStatus getStatus() { return status2; }
-
-    void setStatus(ModelStatus status) { status2 = status; }
-
     ModelStatus getLastStatus() { return lastStatus; }
     void setLastStatus(ModelStatus status) { lastStatus = status; }
 
@@ -767,6 +788,25 @@ private:
         return OpResult::ok();
     }
 
+    // Counts requests and failures per space for the metrics export
+    static void recordOperation(const String& operation, const String& space, const OpResult& result)
+    {
+        StringPairArray labels;
+        labels.set("space", space);
+        labels.set("operation", operation);
+
+        auto* metrics = MetricsRegistry::getInstance();
+
+        metrics->getCounter("harp_requests_total", "Requests made to a space.", labels).increment();
+
+        if (result.failed())
+        {
+            metrics
+                ->getCounter("harp_request_errors_total", "Requests to a space that failed.", labels)
+                .increment();
+        }
+    }
+
     bool isStabilityModel =
         false; // A flag to indicate if the current model is a Stability AI model
     ComponentInfoList controlsInfo;
@@ -797,37 +837,3 @@ private:
     // is the same as the order of the outputTracksInfo
     std::vector<juce::String> outputFilePaths;
 };
-
-// a timer that checks the status of the model and broadcasts a change if if there is one
-class ModelStatusTimer : public juce::Timer, public juce::ChangeBroadcaster
-{
-public:
-    ModelStatusTimer(std::shared_ptr<WebModel> model) : m_model(model) {}
-
-    void timerCallback() override
-    {
-        // get the status of the model
-        ModelStatus status = m_model->getStatus();
-        // DBG("ModelStatusTimer::timerCallback status: " + std::to_string(status)
-        //     + " lastStatus: " + std::to_string(lastStatus));
-
-        // if the status has changed, broadcast a change
-        if (status != lastStatus)
-        {
-            lastStatus = status;
-            sendChangeMessage();
-        }
-    }
-
-    void setModel(std::shared_ptr<WebModel> model)
-    {
-        // stopTimer();
-        m_model = model;
-        // lastStatus = ModelStatus::INITIALIZED;
-        // startTimer(50);
-    }
-
-private:
-    std::shared_ptr<WebModel> m_model;
-    ModelStatus lastStatus;
-};
@@ -0,0 +1,251 @@
+#include "WorkspaceManager.h"
+
+#include "AppSettings.h"
+#include "MetricsRegistry.h"
+
+JUCE_IMPLEMENT_SINGLETON(WorkspaceManager)
+
+WorkspaceManager::WorkspaceManager()
+{
+    rootDirectory =
+        File::getSpecialLocation(File::tempDirectory).getChildFile("HARP").getChildFile("workspace");
+
+    String sessionName = "session_" + Uuid().toString();
+
+    sessionLock = std::make_unique<InterProcessLock>(getLockName(sessionName));
+
+    if (! sessionLock->enter(0))
+    {
+        DBG("WorkspaceManager::WorkspaceManager: Failed to lock session " << sessionName << ".");
+    }
+
+    sessionDirectory = rootDirectory.getChildFile(sessionName);
+
+    Result result = sessionDirectory.createDirectory();
+
+    if (result.failed())
+    {
+        DBG("WorkspaceManager::WorkspaceManager: Failed to create session directory "
+            << sessionDirectory.getFullPathName() << ": " << result.getErrorMessage() << ".");
+    }
+
+    // Left-overs of crashed sessions can be large, so startup does not wait for them
+    cleanupTask = scheduler->submit(TaskScheduler::Lane::Background,
+                                    [this] { cleanOrphanedSessions(); });
+}
+
+WorkspaceManager::~WorkspaceManager()
+{
+    {
+        const ScopedLock sl(tasksLock);
+
+        for (auto& task : { cleanupTask, trimTask })
+        {
+            if (task != nullptr)
+            {
+                task->cancel();
+                task->waitForCompletion();
+            }
+        }
+    }
+
+    if (! sessionDirectory.deleteRecursively())
+    {
+        DBG("WorkspaceManager::~WorkspaceManager: Failed to delete session directory "
+            << sessionDirectory.getFullPathName() << ".");
+    }
+
+    sessionLock->exit();
+
+    clearSingletonInstance();
+}
+
+File WorkspaceManager::createFile(const String& baseName, const String& extension)
+{
+    File file = sessionDirectory.getChildFile(baseName + "_" + Uuid().toString() + extension);
+
+    {
+        const ScopedLock sl(entriesLock);
+
+        entries[file.getFullPathName()].lastUsed = Time::getCurrentTime();
+    }
+
+    // Makes room ahead of the new file
+    trimToQuotaAsync();
+
+    return file;
+}
+
+void WorkspaceManager::retain(const File& file)
+{
+    if (! contains(file))
+    {
+        return;
+    }
+
+    const ScopedLock sl(entriesLock);
+
+    Entry& entry = entries[file.getFullPathName()];
+    entry.numReferences++;
+    entry.lastUsed = Time::getCurrentTime();
+}
+
+void WorkspaceManager::release(const File& file)
+{
+    if (! contains(file))
+    {
+        return;
+    }
+
+    {
+        const ScopedLock sl(entriesLock);
+
+        auto it = entries.find(file.getFullPathName());
+
+        if (it == entries.end() || it->second.numReferences == 0)
+        {
+            jassertfalse; // Released more often than retained
+            return;
+        }
+
+        it->second.numReferences--;
+        it->second.lastUsed = Time::getCurrentTime();
+    }
+
+    trimToQuotaAsync();
+}
+
+void WorkspaceManager::trimToQuotaAsync()
+{
+    const ScopedLock sl(tasksLock);
+
+    // A pending trim will see the latest state anyway
+    if (trimTask != nullptr && ! trimTask->hasFinished())
+    {
+        return;
+    }
+
+    trimTask = scheduler->submit(TaskScheduler::Lane::Background, [this] { trimToQuota(); });
+}
+
+void WorkspaceManager::trimToQuota()
+{
+    int64 quotaBytes =
+        static_cast<int64>(AppSettings::getIntValue("workspaceQuotaMB", defaultQuotaMB)) * 1024
+        * 1024;
+
+    Array<File> files = sessionDirectory.findChildFiles(File::findFiles, false);
+
+    int64 totalSize = 0;
+
+    struct Candidate
+    {
+        File file;
+        Time lastUsed;
+    };
+
+    std::vector<Candidate> candidates;
+
+    Time idleThreshold = Time::getCurrentTime() - RelativeTime::seconds(minIdleSeconds);
+
+    {
+        const ScopedLock sl(entriesLock);
+
+        for (const auto& f : files)
+        {
+            totalSize += f.getSize();
+
+            Time lastUsed = f.getLastModificationTime();
+
+            if (auto it = entries.find(f.getFullPathName()); it != entries.end())
+            {
+                if (it->second.numReferences > 0)
+                {
+                    continue;
+                }
+
+                lastUsed = it->second.lastUsed;
+            }
+
+            if (lastUsed < idleThreshold)
+            {
+                candidates.push_back({ f, lastUsed });
+            }
+        }
+    }
+
+    // Least recently used first
+    std::sort(candidates.begin(),
+              candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.lastUsed < b.lastUsed; });
+
+    for (const auto& candidate : candidates)
+    {
+        if (totalSize <= quotaBytes || TaskScheduler::isCurrentTaskCancelled())
+        {
+            break;
+        }
+
+        const ScopedLock sl(entriesLock);
+
+        // Might have been loaded into a track in the meantime
+        auto it = entries.find(candidate.file.getFullPathName());
+
+        if (it != entries.end() && it->second.numReferences > 0)
+        {
+            continue;
+        }
+
+        int64 size = candidate.file.getSize();
+
+        if (candidate.file.deleteFile())
+        {
+            DBG("WorkspaceManager::trimToQuota: Evicted " << candidate.file.getFileName() << ".");
+
+            totalSize -= size;
+
+            if (it != entries.end())
+            {
+                entries.erase(it);
+            }
+        }
+    }
+
+    MetricsRegistry::getInstance()
+        ->getGauge("harp_workspace_size_bytes", "Size of the session workspace on disk.")
+        .set(static_cast<double>(totalSize));
+}
+
+void WorkspaceManager::cleanOrphanedSessions()
+{
+    for (const auto& directory : rootDirectory.findChildFiles(File::findDirectories, false))
+    {
+        if (TaskScheduler::isCurrentTaskCancelled())
+        {
+            return;
+        }
+
+        if (directory == sessionDirectory)
+        {
+            continue;
+        }
+
+        // Lock can only be taken if the session owning the directory is gone
+        InterProcessLock lock(getLockName(directory.getFileName()));
+
+        if (! lock.enter(0))
+        {
+            continue;
+        }
+
+        if (directory.deleteRecursively())
+        {
+            DBG("WorkspaceManager::cleanOrphanedSessions: Deleted orphaned session directory "
+                << directory.getFullPathName() << ".");
+        }
+
+        lock.exit();
+    }
+}
+
+String WorkspaceManager::getLockName(const String& sessionName) { return "HARP_" + sessionName; }
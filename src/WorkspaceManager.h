@@ -0,0 +1,86 @@
+/**
+ * @file WorkspaceManager.h
+ * @brief Session directory for downloaded and intermediate media files, kept under a quota
+ */
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_events/juce_events.h>
+
+#include "TaskScheduler.h"
+
+#include <map>
+#include <memory>
+
+using namespace juce;
+
+/*
+  Model outputs and other intermediate files are written to a directory of
+  the current session (<temp>/HARP/workspace/<session>), instead of being
+  left in the temporary directory forever.
+
+  Tracks retain the workspace files they show. When the workspace grows
+  beyond its quota (the "workspaceQuotaMB" setting, 2 GB by default), the
+  least recently used files no track refers to are deleted. The session
+  directory is deleted on exit.
+
+  Each session holds an inter-process lock while it runs, which the system
+  releases if the process dies. Directories whose lock can be taken at
+  startup were left behind by a crashed session, and are deleted in the
+  background.
+*/
+class WorkspaceManager : private DeletedAtShutdown
+{
+public:
+    JUCE_DECLARE_SINGLETON(WorkspaceManager, false)
+
+    ~WorkspaceManager();
+
+    // Unique new file in the session directory (e.g., for a download), which is not created yet
+    File createFile(const String& baseName, const String& extension);
+
+    bool contains(const File& file) const { return file.isAChildOf(sessionDirectory); }
+
+    // Files retained by at least one track are never evicted
+    void retain(const File& file);
+    void release(const File& file);
+
+    File getSessionDirectory() const { return sessionDirectory; }
+
+    // Evicts files in the background, if the workspace is over its quota
+    void trimToQuotaAsync();
+
+private:
+    WorkspaceManager();
+
+    void trimToQuota();
+    void cleanOrphanedSessions();
+
+    static String getLockName(const String& sessionName);
+
+    struct Entry
+    {
+        int numReferences = 0;
+        Time lastUsed;
+    };
+
+    // Files used more recently than this are kept, since they may be about to be loaded
+    static constexpr int minIdleSeconds = 60;
+
+    static constexpr int defaultQuotaMB = 2048;
+
+    File rootDirectory;
+    File sessionDirectory;
+
+    std::unique_ptr<InterProcessLock> sessionLock;
+
+    CriticalSection entriesLock;
+    std::map<String, Entry> entries;
+
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    CriticalSection tasksLock;
+    std::shared_ptr<TaskScheduler::TaskHandle> cleanupTask;
+    std::shared_ptr<TaskScheduler::TaskHandle> trimTask;
+};
@@ -79,3 +79,23 @@ String Client::createJsonHeaders() const
 {
     return createCommonHeaders() + getJsonContentTypeHeader();
 }
+
+MetricsRegistry::Histogram& Client::getPhaseLatency(const String& phase) const
+{
+    StringPairArray labels;
+    labels.set("space", spaceInfo.getModelSlashUser());
+    labels.set("phase", phase);
+
+    return MetricsRegistry::getInstance()->getHistogram(
+        "harp_request_phase_seconds", "Duration of each phase of a request to a space.", labels);
+}
+
+MetricsRegistry::Counter& Client::getBytesTransferred(const String& direction) const
+{
+    StringPairArray labels;
+    labels.set("space", spaceInfo.getModelSlashUser());
+    labels.set("direction", direction);
+
+    return MetricsRegistry::getInstance()->getCounter(
+        "harp_transferred_bytes_total", "Bytes of media uploaded to or downloaded from a space.", labels);
+}
@@ -10,6 +10,7 @@
 #include <fstream>
 
 #include "../HarpLogger.h"
+#include "../MetricsRegistry.h"
 #include "../errors.h"
 #include "../utils.h"
 
@@ -48,6 +49,10 @@ protected:
     String createCommonHeaders() const;
     String createJsonHeaders() const;
 
+    // Session metrics of requests to this client's space
+    MetricsRegistry::Histogram& getPhaseLatency(const String& phase) const;
+    MetricsRegistry::Counter& getBytesTransferred(const String& direction) const;
+
     String accessToken;
     URL tokenValidationURL;
 
@@ -1,5 +1,8 @@
 #include "GradioClient.h"
 #include "../errors.h"
+#include "../TaskScheduler.h"
+#include "../TraceRecorder.h"
+#include "../WorkspaceManager.h"
 #include "../external/magic_enum.hpp"
 
 GradioClient::GradioClient() { tokenValidationURL = URL("https://huggingface.co/api/whoami-v2"); }
@@ -17,28 +20,36 @@ OpResult GradioClient::processRequest(Error& error,
                                       std::vector<String>& outputFilePaths,
                                       LabelList& labels)
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::processRequest");
+
     OpResult result = OpResult::ok();
     String eventId;
     String endpoint = "process";
-    result = makePostRequestForEventID(endpoint, eventId, processingPayload);
-    if (result.failed())
+    String response;
+
     {
-        if (result.getError().devMessage.isEmpty())
+        // Queueing and inference on the space, without the uploads and downloads around it
+        MetricsRegistry::ScopedTimer timer(getPhaseLatency("process"));
+
+        result = makePostRequestForEventID(endpoint, eventId, processingPayload);
+        if (result.failed())
         {
-            result.getError().devMessage = "Failed to make post request.";
+            if (result.getError().devMessage.isEmpty())
+            {
+                result.getError().devMessage = "Failed to make post request.";
+            }
+            return result;
         }
-        return result;
-    }
 
-    String response;
-    result = getResponseFromEventID(endpoint, eventId, response, -1);
-    if (result.failed())
-    {
-        if (result.getError().devMessage.isEmpty())
+        result = getResponseFromEventID(endpoint, eventId, response, -1);
+        if (result.failed())
         {
-            result.getError().devMessage = "Failed to make get request";
+            if (result.getError().devMessage.isEmpty())
+            {
+                result.getError().devMessage = "Failed to make get request";
+            }
+            return result;
         }
-        return result;
     }
 
     String responseData;
@@ -271,7 +282,8 @@ OpResult GradioClient::processRequest(Error& error,
         else
         {
             LogAndDBG("The pyharp Gradio app returned a " + procObjType
-                      + " object, that we don't yet support in HARP.");
+                          + " object, that we don't yet support in HARP.",
+                      LogLevel::Warning);
         }
     }
     return result;
@@ -303,6 +315,9 @@ OpResult GradioClient::uploadFileRequest(const File& fileToUpload,
                                          String& uploadedFilePath,
                                          const int timeoutMs) const
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::uploadFileRequest");
+    MetricsRegistry::ScopedTimer timer(getPhaseLatency("upload"));
+
     URL gradioEndpoint = spaceInfo.gradio;
     URL uploadEndpoint = gradioEndpoint.getChildURL("gradio_api").getChildURL("upload");
 
@@ -369,6 +384,7 @@ OpResult GradioClient::uploadFileRequest(const File& fileToUpload,
     }
 
     // DBG("File uploaded successfully, path: " + uploadedFilePath);
+    getBytesTransferred("upload").increment(fileToUpload.getSize());
     return OpResult::ok();
 }
 
@@ -377,6 +393,8 @@ OpResult GradioClient::makePostRequestForEventID(const String endpoint,
                                                  const String jsonBody,
                                                  const int timeoutMs) const
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::makePostRequestForEventID");
+
     // Create the error here, in case we need it
     // All the errors of this function are of type FileUploadError
     Error error;
@@ -459,6 +477,8 @@ OpResult GradioClient::getResponseFromEventID(const String callID,
                                               String& response,
                                               const int timeoutMs) const
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::getResponseFromEventID");
+
     // Create the error here, in case we need it
     Error error;
     error.type = ErrorType::HttpRequestError;
@@ -501,6 +521,13 @@ OpResult GradioClient::getResponseFromEventID(const String callID,
     // Stream the response
     while (! stream->isExhausted())
     {
+        // Stop listening once the task waiting on this event has been cancelled
+        if (TaskScheduler::isCurrentTaskCancelled())
+        {
+            error.devMessage = "Cancelled while waiting for " + callID + "/" + eventID;
+            return OpResult::fail(error);
+        }
+
         response = stream->readNextLine();
 
         DBG(eventID);
@@ -537,6 +564,9 @@ OpResult GradioClient::getControls(Array<var>& inputComponents,
                                    Array<var>& outputComponents,
                                    DynamicObject& cardDict)
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::getControls");
+    MetricsRegistry::ScopedTimer timer(getPhaseLatency("controls"));
+
     String callID = "controls";
     String eventID;
 
@@ -637,6 +667,8 @@ OpResult GradioClient::getControls(Array<var>& inputComponents,
 
 OpResult GradioClient::cancel()
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::cancel");
+
     OpResult result = OpResult::ok();
     String eventId;
     String endpoint = "cancel";
@@ -660,12 +692,13 @@ OpResult GradioClient::downloadFileFromURL(const URL& fileURL,
                                            String& downloadedFilePath,
                                            const int timeoutMs) const
 {
+    HARP_TRACE_SCOPE("network", "GradioClient::downloadFileFromURL");
+    MetricsRegistry::ScopedTimer timer(getPhaseLatency("download"));
+
     // Create the error here, in case we need it
     Error error;
     error.type = ErrorType::FileDownloadError;
 
-    // Determine the local temporary directory for storing the downloaded file
-    File tempDir = File::getSpecialLocation(File::tempDirectory);
     String fileName = fileURL.getFileName();
     // // Add a timestamp to the file name to avoid overwriting
     // // Insert timestamp before the file extension using File operations
@@ -675,7 +708,7 @@ OpResult GradioClient::downloadFileFromURL(const URL& fileURL,
     // fileName = baseName + timestamp + extension;
     String baseName = File::createFileWithoutCheckingPath(fileName).getFileNameWithoutExtension();
     String extension = File::createFileWithoutCheckingPath(fileName).getFileExtension();
-    File downloadedFile = tempDir.getChildFile(baseName + "_" + Uuid().toString() + extension);
+    File downloadedFile = WorkspaceManager::getInstance()->createFile(baseName, extension);
 
     // Create input stream to download the file
     StringPairArray responseHeaders;
@@ -702,11 +735,6 @@ OpResult GradioClient::downloadFileFromURL(const URL& fileURL,
         return OpResult::fail(error);
     }
 
-    // Remove file at target path if one already exists
-    // Before adding this, the new file did not replace the old file
-    // TODO - make file path unique (timestamp or Uuid)
-    downloadedFile.deleteFile();
-
     // Create output stream to save the file locally
     std::unique_ptr<FileOutputStream> fileOutput(downloadedFile.createOutputStream());
 
@@ -718,7 +746,8 @@ OpResult GradioClient::downloadFileFromURL(const URL& fileURL,
     }
 
     // Copy data from the input stream to the output stream
-    fileOutput->writeFromInputStream(*stream, stream->getTotalLength());
+    int64 numBytesDownloaded = fileOutput->writeFromInputStream(*stream, stream->getTotalLength());
+    getBytesTransferred("download").increment(numBytesDownloaded);
 
     // Store the file path where the file was downloaded
     downloadedFilePath = downloadedFile.getFullPathName();
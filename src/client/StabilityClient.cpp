@@ -1,5 +1,7 @@
 #include "StabilityClient.h"
 #include "../errors.h"
+#include "../TraceRecorder.h"
+#include "../WorkspaceManager.h"
 #include "../external/magic_enum.hpp"
 
 StabilityClient::StabilityClient()
@@ -37,6 +39,8 @@ OpResult StabilityClient::uploadFileRequest(const File& fileToUpload,
                                             String& uploadedFilePath,
                                             const int timeoutMs) const
 {
+    HARP_TRACE_SCOPE("network", "StabilityClient::uploadFileRequest");
+
     // TBD. We need the original path of the file.
 
     if (! fileToUpload.existsAsFile())
@@ -82,6 +86,8 @@ OpResult StabilityClient::processTextToAudio(const Array<var>* dataArray,
                                              Error& error,
                                              std::vector<String>& outputFilePaths)
 {
+    HARP_TRACE_SCOPE("network", "StabilityClient::processTextToAudio");
+
     String processID = Uuid().toString();
     shouldCancel.store(false); // Reset cancel flag
 
@@ -163,8 +169,7 @@ OpResult StabilityClient::processTextToAudio(const Array<var>* dataArray,
         return OpResult::fail(error);
     }
 
-    File out = File::getSpecialLocation(File::tempDirectory)
-                   .getChildFile(Uuid().toString() + "." + outputFormat);
+    File out = WorkspaceManager::getInstance()->createFile("text-to-audio", "." + outputFormat);
 
     std::unique_ptr<FileOutputStream> f(out.createOutputStream());
     if (! f || ! f->openedOk())
@@ -191,6 +196,7 @@ OpResult StabilityClient::processTextToAudio(const Array<var>* dataArray,
     }
 
     f->flush();
+    getBytesTransferred("download").increment(f->getPosition());
     outputFilePaths.push_back(URL(out).toString(true));
     return OpResult::ok();
 }
@@ -199,6 +205,8 @@ OpResult StabilityClient::processAudioToAudio(const Array<var>* dataArray,
                                               Error& error,
                                               std::vector<String>& outputFilePaths)
 {
+    HARP_TRACE_SCOPE("network", "StabilityClient::processAudioToAudio");
+
     shouldCancel.store(false); // reset cancel flag
 
     if (dataArray == nullptr || dataArray->isEmpty())
@@ -355,6 +363,7 @@ OpResult StabilityClient::processAudioToAudio(const Array<var>* dataArray,
     }
 
     std::unique_ptr<InputStream> stream = url.createInputStream(opts);
+    getBytesTransferred("upload").increment(static_cast<int64>(blob.getSize()));
 
     if (! stream)
     {
@@ -385,8 +394,7 @@ OpResult StabilityClient::processAudioToAudio(const Array<var>* dataArray,
     // File out = File::getSpecialLocation(File::tempDirectory)
     //           .getChildFile(Uuid().toString() + ".wav");
     String outExt = outputFormat.isNotEmpty() ? "." + outputFormat : ".wav";
-    File out =
-        File::getSpecialLocation(File::tempDirectory).getChildFile(Uuid().toString() + outExt);
+    File out = WorkspaceManager::getInstance()->createFile("audio-to-audio", outExt);
 
     std::unique_ptr<FileOutputStream> f(out.createOutputStream());
 
@@ -410,6 +418,7 @@ OpResult StabilityClient::processAudioToAudio(const Array<var>* dataArray,
         f->write(buf.getData(), (size_t) n);
     }
     f->flush();
+    getBytesTransferred("download").increment(f->getPosition());
 
     outputFilePaths.push_back(URL(out).toString(true));
     return OpResult::ok();
@@ -420,6 +429,9 @@ OpResult StabilityClient::processRequest(Error& error,
                                          std::vector<String>& outputFilePaths,
                                          LabelList& labels)
 {
+    HARP_TRACE_SCOPE("network", "StabilityClient::processRequest");
+    MetricsRegistry::ScopedTimer timer(getPhaseLatency("process"));
+
     OpResult result = OpResult::ok();
 
     // Parse the processingPayload JSON
@@ -474,6 +486,9 @@ OpResult StabilityClient::getControls(Array<var>& inputComponents,
                                       Array<var>& outputComponents,
                                       DynamicObject& cardDict)
 {
+    HARP_TRACE_SCOPE("network", "StabilityClient::getControls");
+    MetricsRegistry::ScopedTimer timer(getPhaseLatency("controls"));
+
     String callID = "controls";
     String eventID;
 
@@ -84,7 +84,10 @@ void IconHelper::drawCenterdAt(juce::Graphics& g,
 
 juce::Font IconHelper::getFont()
 {
-    static Font FontAudioFont(FontAudio_ptr);
+    // Parsed from the embedded data once, the first time an icon is drawn
+    static Font FontAudioFont(
+        juce::Typeface::createSystemTypefaceFor(FontAudioData::FontAudiowebfont_ttf,
+                                                FontAudioData::FontAudiowebfont_ttfSize));
     return FontAudioFont;
 }
 
@@ -12,8 +12,8 @@
   SharedResourcePointer<fontaudio::IconHelper> sharedFontAudio;
  ... wherever you want to use the class below
  
- The FontAudio_ptr member below will be constructed once and its owner class will be
- refcounted thanks to the SharedResourcePointer Magic
+ The typeface is parsed from the embedded data once, the first time getFont() is
+ called, so constructing an IconHelper is cheap
  
  ==============================================================================
  */
@@ -104,11 +104,6 @@ public:
                             juce::Colour colour,
                             juce::Rectangle<int> r,
                             float rotation);
-
-private:
-    juce::Typeface::Ptr FontAudio_ptr =
-        juce::Typeface::createSystemTypefaceFor(FontAudioData::FontAudiowebfont_ttf,
-                                                FontAudioData::FontAudiowebfont_ttfSize);
 };
 
 } // end namespace fontaudio
@@ -92,7 +92,10 @@ void IconHelper::drawCenterdAt(juce::Graphics& g,
 
 juce::Font IconHelper::getFont()
 {
-    static Font fontAwesomeFont(FontAwesome_ptr);
+    // Parsed from the embedded data once, the first time an icon is drawn
+    static Font fontAwesomeFont(
+        juce::Typeface::createSystemTypefaceFor(FontAwesomeData::FontAwesomewebfont_ttf,
+                                                FontAwesomeData::FontAwesomewebfont_ttfSize));
     return fontAwesomeFont;
 }
 
@@ -104,11 +104,6 @@ public:
                             juce::Rectangle<int> r,
                             float rotation);
 
-private:
-    juce::Typeface::Ptr FontAwesome_ptr =
-        juce::Typeface::createSystemTypefaceFor(FontAwesomeData::FontAwesomewebfont_ttf,
-                                                FontAwesomeData::FontAwesomewebfont_ttfSize);
-
     // JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FontAwesome)
 };
 
@@ -1,30 +1,69 @@
 #include "AudioDisplayComponent.h"
 
+#include "MidiBounce.h"
+#include "MidiDisplayComponent.h"
+
+#include "../MetricsRegistry.h"
+
 AudioDisplayComponent::AudioDisplayComponent() : AudioDisplayComponent("Audio Track") {}
 
 AudioDisplayComponent::AudioDisplayComponent(String name, bool req, bool fromDAW, DisplayMode mode)
     : MediaDisplayComponent(name, req, fromDAW, mode)
 {
-    thread.startThread(Thread::Priority::normal);
-
     // Need to repaint when visible range changes
     thumbnail.addChangeListener(this);
 
     thumbnailComponent.addMouseListener(this, true);
     contentComponent.addAndMakeVisible(thumbnailComponent);
 
+    initializeViewModeButton();
+    contentComponent.addChildComponent(viewModeButton);
+
     mediaInstructions =
         "Audio waveform.\nClick and drag to start playback from any point in the waveform\nVertical scroll to zoom in/out.\nHorizontal scroll to move the waveform.";
 }
 
 AudioDisplayComponent::~AudioDisplayComponent()
 {
+    if (decodeState != nullptr)
+    {
+        decodeState->cancelled = true;
+    }
+
     resetTransport();
+    releaseReadAheadThread();
+
+    setMappedAudioFile(File());
 
     thumbnailComponent.removeMouseListener(this);
     thumbnail.removeChangeListener(this);
 }
 
+void AudioDisplayComponent::initializeViewModeButton()
+{
+    // Mode while the waveform is shown
+    showSpectrogramButtonInfo = MultiButton::Mode {
+        "Show-Spectrogram",
+        [this] { setSpectrogramVisible(true); },
+        Colours::lightblue,
+        "Click to show the spectrogram",
+        MultiButton::DrawingMode::IconOnly,
+        fontawesome::BarChart,
+    };
+    // Mode while the spectrogram is shown
+    showWaveformButtonInfo = MultiButton::Mode {
+        "Show-Waveform",
+        [this] { setSpectrogramVisible(false); },
+        Colours::lightblue,
+        "Click to show the waveform",
+        MultiButton::DrawingMode::IconOnly,
+        fontaudio::Waveform,
+    };
+    viewModeButton.addMode(showSpectrogramButtonInfo);
+    viewModeButton.addMode(showWaveformButtonInfo);
+    viewModeButton.setMode(showSpectrogramButtonInfo.label);
+}
+
 StringArray AudioDisplayComponent::getSupportedExtensions()
 {
     StringArray extensions;
@@ -40,73 +79,416 @@ StringArray AudioDisplayComponent::getSupportedExtensions()
     return extensions;
 }
 
+StringArray AudioDisplayComponent::getInstanceExtensions()
+{
+    StringArray extensions = AudioDisplayComponent::getSupportedExtensions();
+
+    // MIDI files can be loaded as their bounce to audio
+    extensions.addArray(MidiDisplayComponent::getSupportedExtensions());
+
+    return extensions;
+}
+
+File AudioDisplayComponent::getFileForUpload()
+{
+    if (MidiBounce::isMidiFile(getOriginalFilePath().getLocalFile()))
+    {
+        return mappedAudioFile;
+    }
+
+    return MediaDisplayComponent::getFileForUpload();
+}
+
 void AudioDisplayComponent::resized()
 {
     MediaDisplayComponent::resized();
 
     // Set thumbnail to fill entire media content area
     thumbnailComponent.setBounds(contentComponent.getLocalBounds());
+
+    // Place view toggle in the top-right corner of the media area
+    viewModeButton.setBounds(contentComponent.getLocalBounds()
+                                 .removeFromTop(viewModeButtonSize)
+                                 .removeFromRight(viewModeButtonSize)
+                                 .reduced(2));
 }
 
-void AudioDisplayComponent::loadMediaFile(const URL& filePath)
+void AudioDisplayComponent::setSpectrogramVisible(bool shouldShow)
 {
-    const auto source = std::make_unique<URLInputSource>(filePath);
+    thumbnailComponent.setSpectrogramVisible(shouldShow);
 
-    File audioFile = filePath.getLocalFile();
+    if (shouldShow)
+    {
+        viewModeButton.setMode(showWaveformButtonInfo.label);
 
-    if (source == nullptr)
+        loadSpectrogramSource();
+    }
+    else
     {
-        DBG("AudioDisplayComponent::loadMediaFile: File " << audioFile.getFullPathName()
-                                                          << " does not exist.");
-        // TODO - better error handing
-        jassertfalse;
-        return;
+        viewModeButton.setMode(showSpectrogramButtonInfo.label);
     }
+}
+
+MediaPreparer AudioDisplayComponent::createMediaPreparer(const URL& filePath)
+{
+    return [filePath](MediaLoadState& loadState) -> std::unique_ptr<PreparedMedia>
+    {
+        File audioFile = filePath.getLocalFile();
+
+        // Display's format manager belongs to the message thread
+        AudioFormatManager jobFormatManager;
+        jobFormatManager.registerBasicFormats();
+
+        auto media = std::make_unique<PreparedAudio>();
+
+        File mappableFile = audioFile;
+
+        if (MidiBounce::isMidiFile(audioFile))
+        {
+            // MIDI is played and displayed through its bounce to audio
+            SharedResourcePointer<DecodedAudioCache> decodedCache;
+
+            mappableFile = decodedCache->render(
+                audioFile, MidiBounce::getCacheVariant(), MidiBounce::renderToFile, loadState);
+
+            if (mappableFile == File())
+            {
+                DBG("AudioDisplayComponent::createMediaPreparer: Failed to bounce file "
+                    << audioFile.getFullPathName() << ".");
+                return nullptr;
+            }
+        }
+
+        auto mappedReader = createMappedReader(jobFormatManager, mappableFile);
+
+        if (mappedReader == nullptr)
+        {
+            // Compressed files are mapped through their decoded version once it exists
+            SharedResourcePointer<DecodedAudioCache> decodedCache;
 
-    auto stream = rawToUniquePtr(source->createInputStream());
+            mappableFile = decodedCache->findDecodedFile(audioFile);
+            mappedReader = createMappedReader(jobFormatManager, mappableFile);
+        }
 
-    if (stream == nullptr)
+        if (mappedReader != nullptr)
+        {
+            media->reader = std::move(mappedReader);
+            media->isMemoryMapped = true;
+            media->mappedFile = mappableFile;
+
+            // Thumbnail builder gets its own view of the same mapping (pages are shared by the OS)
+            media->thumbnailReader = createMappedReader(jobFormatManager, mappableFile);
+
+            loadState.progress = 1.0f;
+
+            return media;
+        }
+
+        const auto source = std::make_unique<URLInputSource>(filePath);
+
+        auto stream = rawToUniquePtr(source->createInputStream());
+
+        if (stream == nullptr)
+        {
+            DBG("AudioDisplayComponent::createMediaPreparer: Failed to load file "
+                << audioFile.getFullPathName() << ".");
+            return nullptr;
+        }
+
+        // Opening a compressed file can involve scanning all of it
+        media->reader = rawToUniquePtr(jobFormatManager.createReaderFor(std::move(stream)));
+
+        if (media->reader == nullptr)
+        {
+            DBG("AudioDisplayComponent::createMediaPreparer: Failed to read file "
+                << audioFile.getFullPathName() << ".");
+            return nullptr;
+        }
+
+        loadState.progress = 0.5f;
+
+        if (loadState.shouldCancel())
+        {
+            return nullptr;
+        }
+
+        media->thumbnailReader.reset(jobFormatManager.createReaderFor(audioFile));
+
+        loadState.progress = 1.0f;
+
+        return media;
+    };
+}
+
+void AudioDisplayComponent::loadMediaFile(const URL& filePath, PreparedMedia& media)
+{
+    auto& audio = static_cast<PreparedAudio&>(media);
+
+    double sampleRate = audio.reader->sampleRate;
+
+    audioFileSource = std::make_unique<AudioFormatReaderSource>(audio.reader.release(), true);
+
+    isMemoryMapped = audio.isMemoryMapped;
+    setMappedAudioFile(audio.mappedFile);
+
+    if (isMemoryMapped)
     {
-        DBG("AudioDisplayComponent::loadMediaFile: Failed to load file "
-            << audioFile.getFullPathName() << ".");
-        // TODO - better error handing
-        jassertfalse;
-        return;
+        // Reads from a mapped file are served by the page cache, so no read-ahead is needed
+        transportSource.setSource(audioFileSource.get(), 0, nullptr, sampleRate);
+    }
+    else
+    {
+        releaseReadAheadThread();
+        readAheadThread = readAheadPool->acquireThread();
+
+        transportSource.setSource(audioFileSource.get(),
+                                  32768, // Amount of samples to buffer ahead
+                                  readAheadThread, // Thread to use for reading-ahead
+                                  sampleRate); // Allows for sample rate correction
     }
 
-    auto reader = rawToUniquePtr(formatManager.createReaderFor(std::move(stream)));
+    thumbnailCache.clear();
+
+    if (audio.thumbnailReader != nullptr)
+    {
+        thumbnail.setReader(audio.thumbnailReader.release(),
+                            filePath.getLocalFile().hashCode64());
+    }
+    else
+    {
+        thumbnail.setSource(new URLInputSource(filePath));
+    }
+
+    if (! isMemoryMapped)
+    {
+        startDecoding(filePath.getLocalFile());
+    }
+}
+
+void AudioDisplayComponent::startDecoding(const File& audioFile)
+{
+    SafePointer<AudioDisplayComponent> safeThis(this);
+
+    decodeState = decodedCache->decodeAsync(audioFile,
+                                            [safeThis](const File& decodedFile)
+                                            {
+                                                if (safeThis != nullptr)
+                                                {
+                                                    safeThis->useDecodedFile(decodedFile);
+                                                }
+                                            });
+}
+
+void AudioDisplayComponent::useDecodedFile(const File& decodedFile)
+{
+    decodeState.reset();
+
+    std::unique_ptr<AudioFormatReader> reader = createMappedReader(formatManager, decodedFile);
 
     if (reader == nullptr)
     {
-        DBG("AudioDisplayComponent::loadMediaFile: Failed to read file "
-            << audioFile.getFullPathName() << ".");
-        // TODO - better error handing
-        jassertfalse;
+        // Keep streaming from the compressed file
+        loadSpectrogramSource();
         return;
     }
 
-    audioFileSource = std::make_unique<AudioFormatReaderSource>(reader.release(), true);
+    double sampleRate = reader->sampleRate;
+
+    // Changing the source stops the transport, so restore where it was
+    double position = transportSource.getCurrentPosition();
+    bool wasPlaying = transportSource.isPlaying();
+
+    auto decodedSource = std::make_unique<AudioFormatReaderSource>(reader.release(), true);
+
+    transportSource.setSource(decodedSource.get(), 0, nullptr, sampleRate);
+    transportSource.setPosition(position);
+
+    releaseReadAheadThread();
+
+    if (wasPlaying)
+    {
+        transportSource.start();
+    }
+
+    // Previous source is only released once the transport no longer uses it
+    audioFileSource = std::move(decodedSource);
 
-    transportSource.setSource(
-        audioFileSource.get(),
-        32768, // Amount of samples to buffer ahead
-        &thread, // Thread to use for reading-ahead
-        audioFileSource->getAudioFormatReader()->sampleRate); // Allows for sample rate correction
+    isMemoryMapped = true;
+    setMappedAudioFile(decodedFile);
+
+    // Finish an incomplete thumbnail from the decoded file instead of decoding twice
+    if (! thumbnail.isFullyLoaded())
+    {
+        if (auto thumbnailReader = createMappedReader(formatManager, decodedFile))
+        {
+            thumbnail.setReader(thumbnailReader.release(), loadedAudioFile.hashCode64());
+        }
+    }
+
+    loadSpectrogramSource();
+}
+
+std::unique_ptr<MemoryMappedAudioFormatReader>
+    AudioDisplayComponent::createMappedReader(AudioFormatManager& manager, const File& audioFile)
+{
+    if (! audioFile.existsAsFile())
+    {
+        return nullptr;
+    }
+
+    // Only uncompressed formats (i.e., WAV and AIFF) support memory-mapped reading
+    AudioFormat* format = manager.findFormatForFileExtension(audioFile.getFileExtension());
+
+    if (format == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto reader = rawToUniquePtr(format->createMemoryMappedReader(audioFile));
+
+    if (reader == nullptr || ! reader->mapEntireFile())
+    {
+        return nullptr;
+    }
+
+    return reader;
 }
 
 void AudioDisplayComponent::resetMedia()
 {
     resetTransport();
+    releaseReadAheadThread();
 
     audioFileSource.reset();
     thumbnail.clear();
+    thumbnailComponent.clearTiles();
+
+    loadedAudioFile = File();
+    viewModeButton.setVisible(false);
+
+    if (decodeState != nullptr)
+    {
+        decodeState->cancelled = true;
+        decodeState.reset();
+    }
+
+    isMemoryMapped = false;
+    setMappedAudioFile(File());
+}
+
+void AudioDisplayComponent::releaseReadAheadThread()
+{
+    if (readAheadThread != nullptr)
+    {
+        readAheadPool->releaseThread(readAheadThread);
+        readAheadThread = nullptr;
+    }
+}
+
+void AudioDisplayComponent::setMappedAudioFile(const File& file)
+{
+    int64 newMappedBytes = file.getSize();
+
+    // Also called from the destructor, which may run after the registry is deleted
+    if (auto* metrics = MetricsRegistry::getInstanceWithoutCreating())
+    {
+        metrics
+            ->getGauge("harp_mapped_audio_bytes",
+                       "Size of the decoded audio files mapped into memory by audio tracks.")
+            .add(static_cast<double>(newMappedBytes - mappedAudioBytes));
+    }
+
+    mappedAudioFile = file;
+    mappedAudioBytes = newMappedBytes;
+}
+
+void AudioDisplayComponent::changeListenerCallback(ChangeBroadcaster* source)
+{
+    if (source == &thumbnail)
+    {
+        thumbnailComponent.invalidateTiles();
+    }
+
+    repaint();
 }
 
 void AudioDisplayComponent::postLoadActions(const URL& filePath)
 {
-    if (auto inputSource = std::make_unique<URLInputSource>(filePath))
+    loadedAudioFile = filePath.getLocalFile();
+
+    if (! isThumbnailTrack())
+    {
+        viewModeButton.setVisible(true);
+    }
+
+    loadSpectrogramSource();
+}
+
+void AudioDisplayComponent::loadSpectrogramSource()
+{
+    // Analysis is only started once the spectrogram is actually shown
+    if (! thumbnailComponent.isSpectrogramVisible() || thumbnailComponent.hasSpectrogramReader()
+        || loadedAudioFile == File())
     {
-        thumbnailCache.clear();
-        thumbnail.setSource(inputSource.release());
+        return;
+    }
+
+    // Spectrogram worker gets its own reader, since readers cannot be shared between threads
+    if (auto reader = createMappedReader(formatManager, mappedAudioFile))
+    {
+        thumbnailComponent.setSpectrogramReader(std::move(reader));
+        return;
     }
+
+    // Decoded file will be mapped once it is ready (see useDecodedFile)
+    if (decodeState != nullptr || isSpectrogramReaderPending)
+    {
+        return;
+    }
+
+    // Opening a compressed file parses its headers (or scans it), so keep it off the message thread
+    isSpectrogramReaderPending = true;
+
+    File audioFile = loadedAudioFile;
+    auto reader = std::make_shared<std::unique_ptr<AudioFormatReader>>();
+    SafePointer<AudioDisplayComponent> safeThis(this);
+
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    scheduler->submit(
+        TaskScheduler::Lane::Interactive,
+        [audioFile, reader, safeThis]
+        {
+            AudioFormatManager jobFormatManager;
+            jobFormatManager.registerBasicFormats();
+
+            reader->reset(jobFormatManager.createReaderFor(audioFile));
+
+            MessageManager::callAsync(
+                [audioFile, reader, safeThis]
+                {
+                    if (safeThis == nullptr)
+                    {
+                        return;
+                    }
+
+                    safeThis->isSpectrogramReaderPending = false;
+
+                    // File may have been replaced in the meantime
+                    if (safeThis->loadedAudioFile != audioFile)
+                    {
+                        safeThis->loadSpectrogramSource();
+                        return;
+                    }
+
+                    if (*reader == nullptr)
+                    {
+                        DBG("AudioDisplayComponent::loadSpectrogramSource: Failed to read file "
+                            << audioFile.getFullPathName() << ".");
+                        return;
+                    }
+
+                    safeThis->thumbnailComponent.setSpectrogramReader(std::move(*reader));
+                });
+        });
 }
@@ -1,25 +1,67 @@
 #pragma once
 
+#include "AudioReadAheadPool.h"
+#include "DecodedAudioCache.h"
 #include "MediaDisplayComponent.h"
+#include "SpectrogramTileCache.h"
+#include "WaveformTileCache.h"
 #include <juce_audio_utils/juce_audio_utils.h>
 
 class AudioThumbnailWrapper : public Component
 {
 public:
-    AudioThumbnailWrapper(AudioThumbnail& t, Range<double>& v) : thumbnail(t), visibleRange(v) {}
+    AudioThumbnailWrapper(AudioThumbnail& t, Range<double>& v)
+        : visibleRange(v),
+          tileCache(t, Colours::lightblue, [this] { repaint(); }),
+          spectrogramCache([this] { repaint(); })
+    {
+    }
 
     void paint(Graphics& g) override
     {
-        g.setColour(Colours::lightblue);
+        if (showSpectrogram)
+        {
+            spectrogramCache.draw(g, getLocalBounds(), visibleRange);
+        }
+        else
+        {
+            tileCache.draw(g, getLocalBounds(), visibleRange);
+        }
+    }
 
-        thumbnail.drawChannels(
-            g, getLocalBounds(), visibleRange.getStart(), visibleRange.getEnd(), 1.0f);
+    // Thumbnail data changed, so tiles need to be rendered again
+    void invalidateTiles() { tileCache.invalidate(); }
+
+    // Thumbnail now refers to a different file
+    void clearTiles()
+    {
+        tileCache.clear();
+        spectrogramCache.setReader(nullptr);
     }
 
-private:
-    AudioThumbnail& thumbnail;
+    void setSpectrogramVisible(bool shouldShow)
+    {
+        showSpectrogram = shouldShow;
+        repaint();
+    }
+
+    bool isSpectrogramVisible() const { return showSpectrogram; }
 
+    void setSpectrogramReader(std::unique_ptr<AudioFormatReader> reader)
+    {
+        spectrogramCache.setReader(std::move(reader));
+        repaint();
+    }
+
+    bool hasSpectrogramReader() { return spectrogramCache.hasReader(); }
+
+private:
     Range<double>& visibleRange;
+
+    WaveformTileCache tileCache;
+    SpectrogramTileCache spectrogramCache;
+
+    bool showSpectrogram = false;
 };
 
 class AudioDisplayComponent : public MediaDisplayComponent
@@ -33,30 +75,81 @@ public:
     ~AudioDisplayComponent() override;
 
     static StringArray getSupportedExtensions();
-    StringArray getInstanceExtensions() override
-    {
-        return AudioDisplayComponent::getSupportedExtensions();
-    }
+    StringArray getInstanceExtensions() override;
+
+    // Bounced audio for MIDI files, otherwise the original file
+    File getFileForUpload() override;
 
     void resized() override;
 
-    void loadMediaFile(const URL& filePath) override;
+    void setSpectrogramVisible(bool shouldShow);
 
     double getTotalLengthInSecs() override { return thumbnail.getTotalLength(); }
 
 private:
+    struct PreparedAudio : public PreparedMedia
+    {
+        std::unique_ptr<AudioFormatReader> reader;
+        std::unique_ptr<AudioFormatReader> thumbnailReader;
+        bool isMemoryMapped = false;
+
+        // File the mapped readers were created from (the source or its decoded version)
+        File mappedFile;
+    };
+
     void resetMedia() override;
 
+    MediaPreparer createMediaPreparer(const URL& filePath) override;
+    void loadMediaFile(const URL& filePath, PreparedMedia& media) override;
     void postLoadActions(const URL& filePath) override;
 
+    void changeListenerCallback(ChangeBroadcaster* source) override;
+
     Component* getMediaComponent() override { return &thumbnailComponent; }
 
     bool shouldRenderLabel(const std::unique_ptr<OutputLabel>& l) const override
     {
-        return dynamic_cast<AudioLabel*>(l.get()) != nullptr;
+        return dynamic_cast<AudioLabel*>(l.get()) != nullptr
+               || dynamic_cast<SpectrogramLabel*>(l.get()) != nullptr;
     }
 
-    TimeSliceThread thread { "Audio File Thread" };
+    void initializeViewModeButton();
+    void loadSpectrogramSource();
+
+    void startDecoding(const File& audioFile);
+    void useDecodedFile(const File& decodedFile);
+    void setMappedAudioFile(const File& file);
+    void releaseReadAheadThread();
+
+    static std::unique_ptr<MemoryMappedAudioFormatReader> createMappedReader(AudioFormatManager& manager,
+                                                                             const File& audioFile);
+
+    // File currently shown, kept to lazily open a reader for the spectrogram
+    File loadedAudioFile;
+    bool isSpectrogramReaderPending = false;
+
+    const int viewModeButtonSize = 22;
+
+    MultiButton viewModeButton;
+    MultiButton::Mode showSpectrogramButtonInfo;
+    MultiButton::Mode showWaveformButtonInfo;
+
+    // Read-ahead threads shared with all other audio tracks
+    SharedResourcePointer<AudioReadAheadPool> readAheadPool;
+
+    // Thread assigned to the current transport source, if it reads ahead
+    TimeSliceThread* readAheadThread = nullptr;
+
+    // Whether the current file is being read through a memory-mapped reader
+    bool isMemoryMapped = false;
+
+    // Memory-mappable version of the current file, if one is available
+    File mappedAudioFile;
+    int64 mappedAudioBytes = 0;
+
+    // Compressed files are decoded once in the background for instant seeking
+    SharedResourcePointer<DecodedAudioCache> decodedCache;
+    std::shared_ptr<MediaLoadState> decodeState;
 
     std::unique_ptr<AudioFormatReaderSource> audioFileSource;
 
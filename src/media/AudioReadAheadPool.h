@@ -0,0 +1,17 @@
+/**
+ * @file AudioReadAheadPool.h
+ * @brief Small pool of read-ahead threads shared by all audio tracks
+ */
+
+#pragma once
+
+#include "TimeSliceThreadPool.h"
+
+// Meant to be held through a SharedResourcePointer
+class AudioReadAheadPool : public TimeSliceThreadPool
+{
+public:
+    AudioReadAheadPool() : TimeSliceThreadPool("Audio Read-Ahead Thread", Thread::Priority::normal)
+    {
+    }
+};
@@ -0,0 +1,350 @@
+#include "AudioTranscoder.h"
+
+#include "SegmentRenderQueue.h"
+
+#include "../TraceRecorder.h"
+
+namespace
+{
+// 4-point Lagrange interpolation at x (0 to 1) between samples[idx] and samples[idx + 1]
+float interpolateLagrange(const float* samples, int idx, float x)
+{
+    float ym1 = samples[idx - 1];
+    float y0 = samples[idx];
+    float y1 = samples[idx + 1];
+    float y2 = samples[idx + 2];
+
+    return ym1 * (-x * (x - 1.0f) * (x - 2.0f) / 6.0f)
+           + y0 * ((x + 1.0f) * (x - 1.0f) * (x - 2.0f) / 2.0f)
+           + y1 * (-(x + 1.0f) * x * (x - 2.0f) / 2.0f)
+           + y2 * ((x + 1.0f) * x * (x - 1.0f) / 6.0f);
+}
+
+// Half the length of the low-pass kernel, in zero crossings of its sinc
+constexpr int sincZeroCrossings = 16;
+constexpr int sincTableResolution = 512;
+
+// Cutoff as a proportion of the output's Nyquist frequency, leaving room for the transition band
+constexpr double antiAliasingRolloff = 0.95;
+
+// Blackman-windowed sinc from 0 to sincZeroCrossings, looked up with linear interpolation
+const std::vector<float>& getSincTable()
+{
+    static const std::vector<float> table = []
+    {
+        std::vector<float> t(static_cast<size_t>(sincZeroCrossings * sincTableResolution + 2),
+                             0.0f);
+
+        for (int i = 0; i <= sincZeroCrossings * sincTableResolution; ++i)
+        {
+            double x = static_cast<double>(i) / sincTableResolution;
+            double phase = MathConstants<double>::pi * x / sincZeroCrossings;
+
+            double sinc = i == 0 ? 1.0
+                                 : std::sin(MathConstants<double>::pi * x)
+                                       / (MathConstants<double>::pi * x);
+            double window = 0.42 + 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+
+            t[static_cast<size_t>(i)] = static_cast<float>(sinc * window);
+        }
+
+        return t;
+    }();
+
+    return table;
+}
+
+/*
+  Low-pass filters the samples around position (in samples of the buffer),
+  with a cutoff relative to the source's Nyquist frequency. Reads up to
+  sincZeroCrossings / cutoff samples on either side.
+*/
+float interpolateWindowedSinc(const float* samples, double position, double cutoff)
+{
+    const std::vector<float>& table = getSincTable();
+
+    double reach = sincZeroCrossings / cutoff;
+
+    int first = static_cast<int>(std::ceil(position - reach));
+    int last = static_cast<int>(std::floor(position + reach));
+
+    double sum = 0.0;
+
+    for (int idx = first; idx <= last; ++idx)
+    {
+        double tablePosition = std::abs(position - idx) * cutoff * sincTableResolution;
+        auto tableIdx = static_cast<size_t>(tablePosition);
+
+        if (tableIdx + 1 >= table.size())
+        {
+            continue;
+        }
+
+        double frac = tablePosition - static_cast<double>(tableIdx);
+        double tap = table[tableIdx] + frac * (table[tableIdx + 1] - table[tableIdx]);
+
+        sum += samples[idx] * tap;
+    }
+
+    // Keeps unity gain at low frequencies
+    return static_cast<float>(sum * cutoff);
+}
+} // namespace
+
+bool AudioTranscoder::canTranscode(const File& sourceFile, const File& referenceFile)
+{
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    // Formats which can also be written (MP3 can only be read)
+    return formatManager.findFormatForFileExtension(sourceFile.getFileExtension()) != nullptr
+           && referenceFile.hasFileExtension(".wav;.bwf;.aiff;.aif;.flac;.ogg");
+}
+
+bool AudioTranscoder::transcodeToMatch(const File& sourceFile,
+                                       const File& referenceFile,
+                                       const File& targetFile,
+                                       const std::function<void(double)>& reportProgress)
+{
+    HARP_TRACE_SCOPE("media", "AudioTranscoder::transcodeToMatch");
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<AudioFormatReader> sourceReader(formatManager.createReaderFor(sourceFile));
+    std::unique_ptr<AudioFormatReader> referenceReader(
+        formatManager.createReaderFor(referenceFile));
+
+    AudioFormat* targetFormat =
+        formatManager.findFormatForFileExtension(referenceFile.getFileExtension());
+
+    if (sourceReader == nullptr || referenceReader == nullptr || targetFormat == nullptr
+        || sourceReader->sampleRate <= 0.0 || referenceReader->sampleRate <= 0.0)
+    {
+        DBG("AudioTranscoder::transcodeToMatch: Cannot convert file "
+            << sourceFile.getFullPathName() << " to the format of "
+            << referenceFile.getFullPathName() << ".");
+        return false;
+    }
+
+    double sampleRate = referenceReader->sampleRate;
+    int numChannels = static_cast<int>(sourceReader->numChannels);
+    int bitsPerSample = chooseBitDepth(*targetFormat, referenceReader->bitsPerSample);
+
+    // Highest bitrate for lossy formats
+    int qualityOptionIndex = referenceFile.hasFileExtension(".ogg")
+                                 ? jmax(0, targetFormat->getQualityOptions().size() - 1)
+                                 : 0;
+
+    double sourceSamplesPerOutputSample = sourceReader->sampleRate / sampleRate;
+
+    int64 totalNumSamples = static_cast<int64>(
+        std::floor(static_cast<double>(sourceReader->lengthInSamples) / sourceSamplesPerOutputSample));
+
+    auto outputStream = targetFile.createOutputStream();
+
+    if (outputStream == nullptr)
+    {
+        DBG("AudioTranscoder::transcodeToMatch: Failed to create file "
+            << targetFile.getFullPathName() << ".");
+        return false;
+    }
+
+    std::unique_ptr<AudioFormatWriter> writer(
+        targetFormat->createWriterFor(outputStream.get(),
+                                      sampleRate,
+                                      static_cast<unsigned int>(numChannels),
+                                      bitsPerSample,
+                                      referenceReader->metadataValues,
+                                      qualityOptionIndex));
+
+    if (writer == nullptr)
+    {
+        DBG("AudioTranscoder::transcodeToMatch: Failed to create writer for "
+            << targetFile.getFullPathName() << ".");
+        return false;
+    }
+
+    // Writer now owns the stream
+    outputStream.release();
+
+    auto segments = std::make_shared<std::vector<Segment>>();
+
+    const int64 segmentLength = static_cast<int64>(segmentLengthInSecs * sampleRate);
+
+    for (int64 startSample = 0; startSample < totalNumSamples; startSample += segmentLength)
+    {
+        segments->push_back({ startSample, jmin(startSample + segmentLength, totalNumSamples) });
+    }
+
+    std::vector<int> segmentLengths;
+
+    for (const auto& segment : *segments)
+    {
+        segmentLengths.push_back(static_cast<int>(segment.endSample - segment.startSample));
+    }
+
+    double startTime = Time::getMillisecondCounterHiRes();
+
+    // Otherwise, segments are decoded one after another with a single reader
+    bool isParallel = supportsParallelDecoding(sourceFile);
+
+    SegmentRenderQueue::Renderer renderer;
+
+    if (isParallel)
+    {
+        // Each render opens its own reader, so renders may outlive this function
+        renderer = [sourceFile, sourceSamplesPerOutputSample, segments](
+                       size_t segmentIdx, AudioBuffer<float>& output)
+        {
+            AudioFormatManager segmentFormatManager;
+            segmentFormatManager.registerBasicFormats();
+
+            std::unique_ptr<AudioFormatReader> segmentReader(
+                segmentFormatManager.createReaderFor(sourceFile));
+
+            if (segmentReader != nullptr)
+            {
+                renderSegment(
+                    *segmentReader, sourceSamplesPerOutputSample, (*segments)[segmentIdx], output);
+            }
+        };
+    }
+    else
+    {
+        // Nothing is rendered ahead, so this thread is the only one using the reader
+        renderer = [&sourceReader, sourceSamplesPerOutputSample, segments](
+                       size_t segmentIdx, AudioBuffer<float>& output)
+        {
+            renderSegment(
+                *sourceReader, sourceSamplesPerOutputSample, (*segments)[segmentIdx], output);
+        };
+    }
+
+    // The user is waiting on the conversion, like on the task running it
+    SegmentRenderQueue renderQueue(
+        TaskScheduler::Lane::Interactive,
+        segmentLengths,
+        numChannels,
+        renderer,
+        isParallel ? static_cast<size_t>(2 * SystemStats::getNumCpus()) : 0);
+
+    bool succeeded = true;
+
+    for (size_t segmentIdx = 0; segmentIdx < renderQueue.getNumSegments(); ++segmentIdx)
+    {
+        if (TaskScheduler::isCurrentTaskCancelled())
+        {
+            succeeded = false;
+            break;
+        }
+
+        std::unique_ptr<AudioBuffer<float>> output = renderQueue.getNextSegment();
+
+        if (! writer->writeFromAudioSampleBuffer(*output, 0, output->getNumSamples()))
+        {
+            succeeded = false;
+            break;
+        }
+
+        reportProgress(static_cast<double>(segmentIdx + 1)
+                       / static_cast<double>(renderQueue.getNumSegments()));
+    }
+
+    if (succeeded)
+    {
+        double lengthInSecs = static_cast<double>(totalNumSamples) / sampleRate;
+        double elapsedSecs = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        DBG("AudioTranscoder::transcodeToMatch: Converted "
+            << lengthInSecs << " seconds of audio in " << elapsedSecs << " seconds.");
+    }
+
+    return succeeded;
+}
+
+bool AudioTranscoder::supportsParallelDecoding(const File& sourceFile)
+{
+    // MP3 readers scan the file for frames, which each reader would repeat
+    return sourceFile.hasFileExtension(".wav;.bwf;.aiff;.aif;.flac;.ogg");
+}
+
+int AudioTranscoder::chooseBitDepth(AudioFormat& format, int referenceBitDepth)
+{
+    Array<int> possibleBitDepths = format.getPossibleBitDepths();
+
+    if (possibleBitDepths.contains(referenceBitDepth) || possibleBitDepths.isEmpty())
+    {
+        return referenceBitDepth;
+    }
+
+    // E.g., 32-bit float to FLAC, which only stores integers
+    possibleBitDepths.sort();
+
+    return possibleBitDepths.getLast();
+}
+
+void AudioTranscoder::renderSegment(AudioFormatReader& reader,
+                                    double sourceSamplesPerOutputSample,
+                                    const Segment& segment,
+                                    AudioBuffer<float>& output)
+{
+    HARP_TRACE_SCOPE("media", "AudioTranscoder::renderSegment");
+
+    int numSamples = output.getNumSamples();
+
+    if (sourceSamplesPerOutputSample == 1.0)
+    {
+        reader.read(&output, 0, numSamples, segment.startSample, true, true);
+        return;
+    }
+
+    auto toSourcePosition = [sourceSamplesPerOutputSample](int64 outputSample)
+    { return static_cast<double>(outputSample) * sourceSamplesPerOutputSample; };
+
+    // Frequencies above the output's Nyquist frequency would alias when downsampling
+    bool isDownsampling = sourceSamplesPerOutputSample > 1.0;
+
+    double cutoff = antiAliasingRolloff / sourceSamplesPerOutputSample;
+
+    // Neighbours the interpolation needs on either side of a position
+    int64 reach =
+        isDownsampling ? static_cast<int64>(std::ceil(sincZeroCrossings / cutoff)) + 1 : 2;
+
+    int64 firstSourceSample =
+        static_cast<int64>(std::floor(toSourcePosition(segment.startSample))) - reach;
+    int64 lastSourceSample =
+        static_cast<int64>(std::floor(toSourcePosition(segment.endSample - 1))) + reach;
+
+    // Reading outside of the file yields silence
+    AudioBuffer<float> source(output.getNumChannels(),
+                              static_cast<int>(lastSourceSample - firstSourceSample + 1));
+    reader.read(&source, 0, source.getNumSamples(), firstSourceSample, true, true);
+
+    for (int channelIdx = 0; channelIdx < output.getNumChannels(); ++channelIdx)
+    {
+        const float* sourceSamples = source.getReadPointer(channelIdx);
+        float* outputSamples = output.getWritePointer(channelIdx);
+
+        for (int sampleIdx = 0; sampleIdx < numSamples; ++sampleIdx)
+        {
+            // Absolute position, so every segment agrees with a continuous render
+            double position = toSourcePosition(segment.startSample + sampleIdx);
+
+            if (isDownsampling)
+            {
+                outputSamples[sampleIdx] = interpolateWindowedSinc(
+                    sourceSamples, position - static_cast<double>(firstSourceSample), cutoff);
+
+                continue;
+            }
+
+            double integerPart = std::floor(position);
+
+            outputSamples[sampleIdx] = interpolateLagrange(
+                sourceSamples,
+                static_cast<int>(static_cast<int64>(integerPart) - firstSourceSample),
+                static_cast<float>(position - integerPart));
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * @file AudioTranscoder.h
+ * @brief Conversion of audio files to the format of another file, e.g., a DAW-linked one
+ */
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include <functional>
+
+using namespace juce;
+
+/*
+  Converts an audio file (e.g., MP3 or FLAC output of a model) to the format,
+  sample rate and bit depth of a reference file, so it can replace a file the
+  DAW is linked to. The metadata of the reference (e.g., the BWF timestamp
+  used to place the clip) is kept.
+
+  As in MidiBounce, the output is split into fixed-length segments, which are
+  decoded and resampled in parallel when the source format can seek to exact
+  samples, and written out in order. Resampling only depends on the position
+  of each output sample, so segments are identical to a continuous render.
+  Downsampling goes through a windowed-sinc low-pass filter, so content above
+  the new Nyquist frequency does not alias.
+*/
+class AudioTranscoder
+{
+public:
+    // Whether the source can be read and converted to the format of the reference
+    static bool canTranscode(const File& sourceFile, const File& referenceFile);
+
+    // Runs on the calling thread (a worker), checking TaskScheduler::isCurrentTaskCancelled()
+    static bool transcodeToMatch(const File& sourceFile,
+                                 const File& referenceFile,
+                                 const File& targetFile,
+                                 const std::function<void(double)>& reportProgress);
+
+private:
+    struct Segment
+    {
+        // In samples of the output
+        int64 startSample = 0;
+        int64 endSample = 0;
+    };
+
+    // Whether readers of the format seek to exact samples cheaply
+    static bool supportsParallelDecoding(const File& sourceFile);
+
+    static int chooseBitDepth(AudioFormat& format, int referenceBitDepth);
+
+    static void renderSegment(AudioFormatReader& reader,
+                              double sourceSamplesPerOutputSample,
+                              const Segment& segment,
+                              AudioBuffer<float>& output);
+
+    static constexpr double segmentLengthInSecs = 10.0;
+};
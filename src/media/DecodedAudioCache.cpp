@@ -0,0 +1,269 @@
+#include "DecodedAudioCache.h"
+
+#include "../MetricsRegistry.h"
+#include "../TraceRecorder.h"
+
+DecodedAudioCache::DecodedAudioCache()
+{
+    cacheDirectory =
+        File::getSpecialLocation(File::tempDirectory).getChildFile("HARP").getChildFile("decoded");
+
+    Result result = cacheDirectory.createDirectory();
+
+    if (result.failed())
+    {
+        DBG("DecodedAudioCache::DecodedAudioCache: Failed to create cache directory "
+            << cacheDirectory.getFullPathName() << ": " << result.getErrorMessage() << ".");
+    }
+}
+
+File DecodedAudioCache::findRenderedFile(const File& sourceFile, const String& variant)
+{
+    String key = getContentKey(sourceFile);
+
+    if (key.isEmpty())
+    {
+        return {};
+    }
+
+    File renderedFile = getCacheFile(key, variant);
+
+    if (! renderedFile.existsAsFile())
+    {
+        return {};
+    }
+
+    // Modification time doubles as the last time an entry was used
+    renderedFile.setLastModificationTime(Time::getCurrentTime());
+
+    return renderedFile;
+}
+
+std::shared_ptr<MediaLoadState>
+    DecodedAudioCache::decodeAsync(const File& sourceFile,
+                                   std::function<void(const File&)> onDecoded)
+{
+    auto loadState = std::make_shared<MediaLoadState>();
+
+    // Holding a reference keeps the cache alive until the decode is done
+    SharedResourcePointer<DecodedAudioCache> cache;
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    scheduler->submit(
+        TaskScheduler::Lane::Background,
+        [cache, sourceFile, loadState, onDecoded]
+        {
+            if (loadState->shouldCancel())
+            {
+                return;
+            }
+
+            File decodedFile = cache->render(sourceFile, {}, decode, *loadState);
+
+            MessageManager::callAsync(
+                [decodedFile, loadState, onDecoded]
+                {
+                    if (! loadState->shouldCancel())
+                    {
+                        onDecoded(decodedFile);
+                    }
+                });
+        });
+
+    return loadState;
+}
+
+File DecodedAudioCache::render(const File& sourceFile,
+                               const String& variant,
+                               const Renderer& renderer,
+                               MediaLoadState& loadState)
+{
+    StringPairArray labels;
+    labels.set("variant", variant.isEmpty() ? "decoded" : variant);
+
+    auto* metrics = MetricsRegistry::getInstance();
+
+    // Another display may have asked for the same file
+    if (File renderedFile = findRenderedFile(sourceFile, variant); renderedFile.existsAsFile())
+    {
+        metrics->getCounter("harp_media_cache_hits_total", "Media renders served from the cache.", labels)
+            .increment();
+        return renderedFile;
+    }
+
+    metrics->getCounter("harp_media_cache_misses_total", "Media renders not found in the cache.", labels)
+        .increment();
+
+    String key = getContentKey(sourceFile);
+
+    if (key.isEmpty())
+    {
+        return {};
+    }
+
+    File renderedFile = getCacheFile(key, variant);
+
+    // Written under a unique temporary name, so an interrupted or concurrent render is never picked up
+    File partialFile = cacheDirectory.getChildFile(Uuid().toString() + ".part");
+
+    if (! renderer(sourceFile, partialFile, loadState) || loadState.shouldCancel()
+        || ! partialFile.moveFileTo(renderedFile))
+    {
+        partialFile.deleteFile();
+        return {};
+    }
+
+    trimToQuota(renderedFile);
+
+    return renderedFile;
+}
+
+bool DecodedAudioCache::decode(const File& sourceFile,
+                               const File& targetFile,
+                               MediaLoadState& loadState)
+{
+    HARP_TRACE_SCOPE("media", "DecodedAudioCache::decode");
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(sourceFile));
+
+    if (reader == nullptr)
+    {
+        DBG("DecodedAudioCache::decode: Failed to read file " << sourceFile.getFullPathName()
+                                                               << ".");
+        return false;
+    }
+
+    auto outputStream = targetFile.createOutputStream();
+
+    if (outputStream == nullptr)
+    {
+        DBG("DecodedAudioCache::decode: Failed to create file " << targetFile.getFullPathName()
+                                                                 << ".");
+        return false;
+    }
+
+    WavAudioFormat wavFormat;
+
+    std::unique_ptr<AudioFormatWriter> writer(
+        wavFormat.createWriterFor(outputStream.get(),
+                                  reader->sampleRate,
+                                  reader->numChannels,
+                                  32, // Float samples, so decoding is lossless
+                                  {},
+                                  0));
+
+    if (writer == nullptr)
+    {
+        DBG("DecodedAudioCache::decode: Failed to create writer for "
+            << targetFile.getFullPathName() << ".");
+        return false;
+    }
+
+    // Writer now owns the stream
+    outputStream.release();
+
+    int64 numSamples = reader->lengthInSamples;
+
+    for (int64 startSample = 0; startSample < numSamples; startSample += decodeBlockSize)
+    {
+        if (loadState.shouldCancel())
+        {
+            return false;
+        }
+
+        int numToWrite = static_cast<int>(jmin<int64>(decodeBlockSize, numSamples - startSample));
+
+        if (! writer->writeFromAudioReader(*reader, startSample, numToWrite))
+        {
+            DBG("DecodedAudioCache::decode: Failed to decode file "
+                << sourceFile.getFullPathName() << ".");
+            return false;
+        }
+
+        loadState.progress = static_cast<float>(startSample + numToWrite)
+                             / static_cast<float>(jmax<int64>(1, numSamples));
+    }
+
+    return true;
+}
+
+String DecodedAudioCache::getContentKey(const File& sourceFile)
+{
+    if (! sourceFile.existsAsFile())
+    {
+        return {};
+    }
+
+    // Hashing reads the whole file, so only do it once per version of a file
+    String fileState = sourceFile.getFullPathName() + "|" + String(sourceFile.getSize()) + "|"
+                       + String(sourceFile.getLastModificationTime().toMilliseconds());
+
+    {
+        const ScopedLock sl(contentKeysLock);
+
+        if (auto it = contentKeys.find(fileState); it != contentKeys.end())
+        {
+            return it->second;
+        }
+    }
+
+    String key = SHA256(sourceFile).toHexString();
+
+    const ScopedLock sl(contentKeysLock);
+
+    contentKeys[fileState] = key;
+
+    return key;
+}
+
+File DecodedAudioCache::getCacheFile(const String& key, const String& variant) const
+{
+    return cacheDirectory.getChildFile(variant.isEmpty() ? key + ".wav"
+                                                         : key + "_" + variant + ".wav");
+}
+
+void DecodedAudioCache::trimToQuota(const File& fileToKeep)
+{
+    Array<File> entries = cacheDirectory.findChildFiles(File::findFiles, false, "*.wav");
+
+    int64 totalSize = 0;
+
+    for (const auto& f : entries)
+    {
+        totalSize += f.getSize();
+    }
+
+    // Least recently used first
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const File& a, const File& b)
+              { return a.getLastModificationTime() < b.getLastModificationTime(); });
+
+    for (const auto& f : entries)
+    {
+        if (totalSize <= maxCacheSizeBytes)
+        {
+            break;
+        }
+
+        if (f == fileToKeep)
+        {
+            continue;
+        }
+
+        int64 size = f.getSize();
+
+        // Fails harmlessly (e.g., on Windows) while the file is still mapped by a display
+        if (f.deleteFile())
+        {
+            totalSize -= size;
+        }
+    }
+
+    MetricsRegistry::getInstance()
+        ->getGauge("harp_media_cache_size_bytes", "Size of the decoded media cache on disk.")
+        .set(static_cast<double>(totalSize));
+}
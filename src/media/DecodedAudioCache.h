@@ -0,0 +1,83 @@
+/**
+ * @file DecodedAudioCache.h
+ * @brief Compressed audio files decoded once into memory-mappable PCM files
+ */
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_cryptography/juce_cryptography.h>
+#include <juce_events/juce_events.h>
+
+#include "../TaskScheduler.h"
+#include "MediaLoader.h"
+
+#include <map>
+
+using namespace juce;
+
+/*
+  Compressed formats (e.g., MP3 and OGG) are decoded on the fly, so every seek
+  has to decode from the nearest sync point onwards. Decoding a file once into
+  a 32-bit float WAV file instead lets playback, scrubbing and the thumbnail go
+  through a memory-mapped reader, where seeking costs nothing.
+
+  Other renderings of a source (e.g., MIDI bounced to audio) are stored the
+  same way under a variant name.
+
+  Decoded files are keyed by a hash of the source's content, so renamed or
+  copied files share an entry and modified files never hit a stale one. The
+  least recently used entries are deleted when the cache grows beyond its
+  quota. Meant to be held through a SharedResourcePointer.
+*/
+class DecodedAudioCache
+{
+public:
+    // Writes a rendering of the source file to the target file, returning false on failure
+    using Renderer =
+        std::function<bool(const File& sourceFile, const File& targetFile, MediaLoadState&)>;
+
+    DecodedAudioCache();
+
+    // Previously decoded version of a file, or File() if it has not been decoded yet
+    File findDecodedFile(const File& sourceFile) { return findRenderedFile(sourceFile, {}); }
+
+    // Previously rendered variant of a file, or File() if it has not been rendered yet
+    File findRenderedFile(const File& sourceFile, const String& variant);
+
+    // Render a variant of a file on the calling thread, unless it is cached already
+    File render(const File& sourceFile,
+                const String& variant,
+                const Renderer& renderer,
+                MediaLoadState& loadState);
+
+    /*
+      Decode a file in the scheduler's background lane. The callback is invoked
+      on the message thread with the decoded file (or File() on failure),
+      unless the returned state is cancelled first.
+    */
+    std::shared_ptr<MediaLoadState> decodeAsync(const File& sourceFile,
+                                                std::function<void(const File&)> onDecoded);
+
+private:
+    static bool decode(const File& sourceFile, const File& targetFile, MediaLoadState& loadState);
+
+    String getContentKey(const File& sourceFile);
+    File getCacheFile(const String& key, const String& variant) const;
+
+    void trimToQuota(const File& fileToKeep);
+
+    // Number of samples decoded between checks for cancellation
+    static constexpr int decodeBlockSize = 65536;
+
+    // Roughly two hours of stereo audio at 44.1kHz
+    static constexpr int64 maxCacheSizeBytes = 2LL * 1024 * 1024 * 1024;
+
+    File cacheDirectory;
+
+    // Content keys of files already hashed, by path, size and modification time
+    std::map<String, String> contentKeys;
+    CriticalSection contentKeysLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedAudioCache)
+};
@@ -0,0 +1,79 @@
+#include "LabelIndex.h"
+
+void LabelIndex::add(DisplayLabel label)
+{
+    labels.push_back(std::move(label));
+
+    isSorted = false;
+}
+
+void LabelIndex::removeFrom(int processingIndex)
+{
+    labels.erase(std::remove_if(labels.begin(),
+                                labels.end(),
+                                [processingIndex](const DisplayLabel& l)
+                                { return l.processingIndex >= processingIndex; }),
+                 labels.end());
+
+    isSorted = false;
+}
+
+void LabelIndex::clear()
+{
+    labels.clear();
+
+    isSorted = false;
+}
+
+int LabelIndex::getNumLabels(int processingIndex)
+{
+    updateSortedLabels(processingIndex);
+
+    return static_cast<int>(sortedLabels.size());
+}
+
+Range<int> LabelIndex::findByCentreTime(Range<double> timeRange, int processingIndex)
+{
+    updateSortedLabels(processingIndex);
+
+    auto first = std::lower_bound(
+        sortedCentreTimes.begin(), sortedCentreTimes.end(), timeRange.getStart());
+    auto last = std::lower_bound(first, sortedCentreTimes.end(), timeRange.getEnd());
+
+    return { static_cast<int>(first - sortedCentreTimes.begin()),
+             static_cast<int>(last - sortedCentreTimes.begin()) };
+}
+
+void LabelIndex::updateSortedLabels(int processingIndex)
+{
+    if (isSorted && sortedProcessingIndex == processingIndex)
+    {
+        return;
+    }
+
+    sortedLabels.clear();
+
+    for (const auto& l : labels)
+    {
+        if (l.processingIndex == processingIndex)
+        {
+            sortedLabels.push_back(&l);
+        }
+    }
+
+    std::stable_sort(sortedLabels.begin(),
+                     sortedLabels.end(),
+                     [](const DisplayLabel* a, const DisplayLabel* b)
+                     { return a->getCentreTime() < b->getCentreTime(); });
+
+    sortedCentreTimes.clear();
+    sortedCentreTimes.reserve(sortedLabels.size());
+
+    for (auto* l : sortedLabels)
+    {
+        sortedCentreTimes.push_back(l->getCentreTime());
+    }
+
+    isSorted = true;
+    sortedProcessingIndex = processingIndex;
+}
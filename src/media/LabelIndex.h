@@ -0,0 +1,70 @@
+/**
+ * @file LabelIndex.h
+ * @brief Output labels of a media display, indexed by time for visible-range queries
+ */
+
+#pragma once
+
+#include "juce_graphics/juce_graphics.h"
+
+#include <vector>
+
+using namespace juce;
+
+// Everything needed to draw a single output label
+struct DisplayLabel
+{
+    double time = 0.0;
+    double duration = 0.0;
+    String text;
+    String description;
+    Colour color = Colours::purple.withAlpha(0.8f);
+    String link;
+
+    // Vertical position within the media (only used for overlays)
+    float relativeY = 0.0f;
+
+    int processingIndex = 0;
+
+    double getCentreTime() const { return time + duration / 2.0; }
+};
+
+/*
+  Labels are drawn centred on the midpoint of their time span, with a width
+  that is capped relative to the media width. Sorting by centre time is
+  therefore enough to find every label that could touch a given range, and
+  lookups only cost a binary search regardless of how many labels exist.
+*/
+class LabelIndex
+{
+public:
+    void add(DisplayLabel label);
+
+    // Remove labels produced at or after the given processing index
+    void removeFrom(int processingIndex);
+
+    void clear();
+
+    int getNumLabels(int processingIndex);
+
+    // Positions of labels whose centre lies within the range, in centre-time order
+    Range<int> findByCentreTime(Range<double> timeRange, int processingIndex);
+
+    // Valid for positions returned by the most recent query
+    const DisplayLabel& getLabel(int position) const
+    {
+        return *sortedLabels[static_cast<size_t>(position)];
+    }
+
+private:
+    void updateSortedLabels(int processingIndex);
+
+    std::vector<DisplayLabel> labels;
+
+    // Labels for a single processing index, sorted by centre time
+    std::vector<const DisplayLabel*> sortedLabels;
+    std::vector<double> sortedCentreTimes;
+
+    bool isSorted = false;
+    int sortedProcessingIndex = 0;
+};
@@ -0,0 +1,161 @@
+#include "LabelLayerComponent.h"
+#include "SpectrogramTileCache.h"
+
+LabelLayerComponent::LabelLayerComponent()
+{
+    // Boxes are the only interactive parts of the layer (see hitTest)
+    setInterceptsMouseClicks(true, false);
+}
+
+void LabelLayerComponent::setLabelBoxes(std::vector<LabelBox> newBoxes)
+{
+    // Hovered box no longer exists after a new layout
+    setHoveredBox(-1);
+
+    boxes = std::move(newBoxes);
+
+    repaint();
+}
+
+void LabelLayerComponent::setMarkers(Range<float> range, Colour c)
+{
+    showMarkers = ! c.isTransparent();
+    markerRange = range;
+    markerColor = c;
+
+    repaint();
+}
+
+void LabelLayerComponent::paint(Graphics& g)
+{
+    if (showMarkers)
+    {
+        float height = static_cast<float>(getHeight());
+        float markerRadius = markerWidth / 2.0f;
+
+        g.setColour(markerColor.withAlpha(0.5f));
+        g.fillRect(markerRange.getStart() + markerRadius, 0.0f, markerRange.getLength(), height);
+
+        g.setColour(markerColor);
+        g.fillRect(markerRange.getStart(), 0.0f, markerWidth, height);
+        g.fillRect(markerRange.getEnd(), 0.0f, markerWidth, height);
+    }
+
+    Rectangle<float> clipBounds = g.getClipBounds().toFloat();
+
+    g.setFont(labelFont);
+
+    for (const auto& b : boxes)
+    {
+        if (! b.bounds.intersects(clipBounds))
+        {
+            continue;
+        }
+
+        g.setColour(b.color);
+        g.fillRect(b.bounds);
+
+        // Same insets as a juce::Label
+        g.setColour(Colours::white);
+        g.drawFittedText(b.text,
+                         b.bounds.toNearestInt().reduced(5, 1),
+                         Justification::centred,
+                         1,
+                         0.0f);
+    }
+}
+
+bool LabelLayerComponent::hitTest(int x, int y)
+{
+    return findBoxAt(Point<int>(x, y).toFloat()) >= 0;
+}
+
+float LabelLayerComponent::amplitudeToRelativeY(float amplitude)
+{
+    return jmin(1.0f, jmax(0.0f, 1 - (amplitude + 1) / 2));
+}
+
+float LabelLayerComponent::frequencyToRelativeY(float frequency)
+{
+    // Must match the frequency axis of the spectrogram being overlaid
+    return SpectrogramTileCache::frequencyToRelativeY(frequency);
+}
+
+float LabelLayerComponent::pitchToRelativeY(float pitch)
+{
+    return jmin(1.0f, jmax(0.0f, 1 - pitch / 128));
+}
+
+juce::MouseCursor LabelLayerComponent::getMouseCursor()
+{
+    if (hoveredBox >= 0 && boxes[static_cast<size_t>(hoveredBox)].link.isNotEmpty())
+        return juce::MouseCursor::PointingHandCursor;
+    else
+        return juce::MouseCursor::NormalCursor;
+}
+
+void LabelLayerComponent::mouseMove(const MouseEvent& e) { setHoveredBox(findBoxAt(e.position)); }
+
+void LabelLayerComponent::mouseExit(const MouseEvent& /*e*/) { setHoveredBox(-1); }
+
+void LabelLayerComponent::mouseUp(const MouseEvent& e)
+{
+    int boxIndex = findBoxAt(e.position);
+
+    if (boxIndex < 0)
+    {
+        return;
+    }
+
+    String lnk = boxes[static_cast<size_t>(boxIndex)].link;
+
+    if (lnk.isNotEmpty())
+    {
+        URL url = URL(lnk);
+
+        if (url.isWellFormed())
+        {
+            url.launchInDefaultBrowser();
+        }
+        else
+        {
+            DBG("LabelLayerComponent::mouseUp: label link \'" << lnk << "\' appears malformed.");
+        }
+    }
+}
+
+int LabelLayerComponent::findBoxAt(Point<float> p) const
+{
+    // Boxes painted last are on top
+    for (int i = static_cast<int>(boxes.size()) - 1; i >= 0; --i)
+    {
+        if (boxes[static_cast<size_t>(i)].bounds.contains(p))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void LabelLayerComponent::setHoveredBox(int boxIndex)
+{
+    if (boxIndex == hoveredBox)
+    {
+        return;
+    }
+
+    hoveredBox = boxIndex;
+
+    const LabelBox* box = hoveredBox >= 0 ? &boxes[static_cast<size_t>(hoveredBox)] : nullptr;
+
+    if (instructionBox != nullptr)
+    {
+        instructionBox->setStatusMessage(box != nullptr ? box->description : String());
+    }
+
+    if (onHoverChanged)
+    {
+        onHoverChanged(box);
+    }
+}
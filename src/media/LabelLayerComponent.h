@@ -0,0 +1,81 @@
+/**
+ * @file LabelLayerComponent.h
+ * @brief Single component painting all visible output labels of a media display
+ */
+
+#pragma once
+
+#include "juce_gui_basics/juce_gui_basics.h"
+
+#include "../gui/StatusComponent.h"
+
+using namespace juce;
+
+/*
+  Paints every visible output label of one kind (overhead or overlay) for a
+  media display, in place of a component per label. The owning display lays
+  out the boxes for the visible range; clicks only land on this layer where a
+  box is drawn, so the media underneath stays interactive everywhere else.
+*/
+class LabelLayerComponent : public Component
+{
+public:
+    // A single label, or a cluster of labels that would otherwise overlap
+    struct LabelBox
+    {
+        Rectangle<float> bounds;
+
+        String text;
+        String description;
+        Colour color;
+        String link;
+
+        int numLabels = 1;
+
+        // Horizontal extent of the labelled time span (marker positions)
+        Range<float> markerRange;
+    };
+
+    LabelLayerComponent();
+
+    void setLabelBoxes(std::vector<LabelBox> newBoxes);
+    int getNumLabelBoxes() const { return static_cast<int>(boxes.size()); }
+
+    void setLabelFont(Font f) { labelFont = f; }
+
+    // Highlight a labelled time span across the full height of the layer
+    void setMarkers(Range<float> range, Colour c);
+    void clearMarkers() { setMarkers({}, Colours::transparentBlack); }
+
+    // Called when the hovered box changes (nullptr when no box is hovered)
+    std::function<void(const LabelBox*)> onHoverChanged;
+
+    void paint(Graphics& g) override;
+    bool hitTest(int x, int y) override;
+
+    static float amplitudeToRelativeY(float amplitude);
+    static float frequencyToRelativeY(float frequency);
+    static float pitchToRelativeY(float pitch);
+
+private:
+    MouseCursor getMouseCursor() override;
+    void mouseMove(const MouseEvent& e) override;
+    void mouseExit(const MouseEvent& e) override;
+    void mouseUp(const MouseEvent& e) override;
+
+    int findBoxAt(Point<float> p) const;
+    void setHoveredBox(int boxIndex);
+
+    const float markerWidth = 1.5f;
+
+    std::vector<LabelBox> boxes;
+    int hoveredBox = -1;
+
+    Font labelFont;
+
+    bool showMarkers = false;
+    Range<float> markerRange;
+    Colour markerColor;
+
+    SharedResourcePointer<InstructionBox> instructionBox;
+};
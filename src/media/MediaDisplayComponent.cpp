@@ -2,6 +2,36 @@
 #include "AudioDisplayComponent.h"
 #include "MidiDisplayComponent.h"
 
+#include "../MetricsRegistry.h"
+#include "../TraceRecorder.h"
+#include "../WorkspaceManager.h"
+
+#include <map>
+
+namespace
+{
+// Tracks can outlive the registry at shutdown, which must not be recreated then
+MetricsRegistry::Gauge* getTrackCountGauge()
+{
+    auto* metrics = MetricsRegistry::getInstanceWithoutCreating();
+
+    return metrics != nullptr
+               ? &metrics->getGauge("harp_tracks", "Media tracks currently open.")
+               : nullptr;
+}
+
+MetricsRegistry::Gauge* getAudioLoadGauge()
+{
+    auto* metrics = MetricsRegistry::getInstanceWithoutCreating();
+
+    return metrics != nullptr
+               ? &metrics->getGauge(
+                   "harp_audio_callback_load",
+                   "Proportion of the audio callback period used during playback (0 to 1).")
+               : nullptr;
+}
+} // namespace
+
 MediaDisplayComponent::MediaDisplayComponent() : MediaDisplayComponent("Media Track") {}
 
 MediaDisplayComponent::MediaDisplayComponent(String name, bool req, bool fromDAW, DisplayMode mode)
@@ -9,8 +39,10 @@ MediaDisplayComponent::MediaDisplayComponent(String name, bool req, bool fromDAW
 {
     formatManager.registerBasicFormats();
 
-    deviceManager.initialise(0, 2, nullptr, true, {}, nullptr);
-    deviceManager.addAudioCallback(&sourcePlayer);
+    if (auto* gauge = getTrackCountGauge())
+    {
+        gauge->add(1.0);
+    }
 
     sourcePlayer.setSource(&transportSource);
 
@@ -36,9 +68,22 @@ MediaDisplayComponent::MediaDisplayComponent(String name, bool req, bool fromDAW
     horizontalScrollBar.setAutoHide(false);
     horizontalScrollBar.addListener(this);
 
+    Font labelFont(static_cast<float>(jmax(minFontSize, labelHeight - 2 * textSpacing)));
+
+    overheadLabelLayer.setLabelFont(labelFont);
+    overheadLabelLayer.onHoverChanged = [this](const LabelLayerComponent::LabelBox* b)
+    { setLabelMarkers(b); };
+    overheadPanel.addAndMakeVisible(overheadLabelLayer);
+
+    // Overlay layer is attached to the media component once it is known (see repositionLabels)
+    overlayLabelLayer.setLabelFont(labelFont);
+    overlayLabelLayer.onHoverChanged = [this](const LabelLayerComponent::LabelBox* b)
+    { setLabelMarkers(b); };
+
     mediaAreaContainer.addAndMakeVisible(overheadPanel);
     mediaAreaContainer.addAndMakeVisible(contentComponent);
     mediaAreaContainer.addAndMakeVisible(horizontalScrollBar);
+    mediaAreaContainer.addChildComponent(loadingOverlay);
     addAndMakeVisible(mediaAreaContainer);
 
     mediaAreaFlexBox.flexDirection = FlexBox::Direction::column;
@@ -122,6 +167,8 @@ void MediaDisplayComponent::initializeButtons()
 
 MediaDisplayComponent::~MediaDisplayComponent()
 {
+    cancelLoading();
+
     deviceManager.removeAudioCallback(&sourcePlayer);
 
     sourcePlayer.setSource(nullptr);
@@ -129,6 +176,15 @@ MediaDisplayComponent::~MediaDisplayComponent()
     headerComponent.removeMouseListener(this);
     horizontalScrollBar.removeListener(this);
 
+    WorkspaceManager::getInstance()->release(originalFilePath.getLocalFile());
+
+    setActiveEntry(nullptr);
+
+    if (auto* gauge = getTrackCountGauge())
+    {
+        gauge->add(-1.0);
+    }
+
     //clearLabels(); // Seems to cause problems when re-loading model
 }
 
@@ -145,6 +201,8 @@ StringArray MediaDisplayComponent::getSupportedExtensions()
 
 void MediaDisplayComponent::paint(Graphics& g)
 {
+    HARP_TRACE_SCOPE("ui", "MediaDisplayComponent::paint");
+
     if (isThumbnailTrack() && isCurrentlySelected())
     {
         g.fillAll(selectionColor);
@@ -181,6 +239,8 @@ void MediaDisplayComponent::paint(Graphics& g)
 
 void MediaDisplayComponent::resized()
 {
+    HARP_TRACE_SCOPE("ui", "MediaDisplayComponent::resized");
+
     Rectangle<int> totalBounds = getLocalBounds();
 
     // Remove existing items in main flex
@@ -302,94 +362,261 @@ void MediaDisplayComponent::resized()
     // Perform layout in media area
     mediaAreaFlexBox.performLayout(mediaAreaContainer.getLocalBounds());
 
+    loadingOverlay.setBounds(contentComponent.getBounds());
+
     if (! isLabelRepositioningScheduled)
     {
         isLabelRepositioningScheduled = true;
 
         // Defer label repositioning until all layout passes are complete
+        SafePointer<MediaDisplayComponent> safeThis(this);
+
         MessageManager::callAsync(
-            [this]()
+            [safeThis]()
             {
-                isLabelRepositioningScheduled = false;
+                // The display may have been removed in the meantime
+                if (safeThis == nullptr)
+                {
+                    return;
+                }
+
+                safeThis->isLabelRepositioningScheduled = false;
 
-                repositionLabels();
+                safeThis->repositionLabels();
             });
     }
 }
 
 void MediaDisplayComponent::repositionLabels()
 {
+    Component* mediaComponentPtr = getMediaComponent();
+
+    if (overlayLabelLayer.getParentComponent() != mediaComponentPtr)
+    {
+        mediaComponentPtr->addAndMakeVisible(overlayLabelLayer);
+    }
+
+    overlayLabelLayer.setBounds(mediaComponentPtr->getLocalBounds());
+    overlayLabelLayer.toFront(false);
+
+    overheadLabelLayer.setBounds(overheadPanel.getLocalBounds());
+
     if (! isFileLoaded())
     {
+        overheadLabelLayer.setLabelBoxes({});
+        overlayLabelLayer.setLabelBoxes({});
+
         return;
     }
 
+    // Cost depends on the number of visible boxes, not the total number of labels
+    overheadLabelLayer.setLabelBoxes(layoutLabels(overheadLabels, false));
+    overlayLabelLayer.setLabelBoxes(layoutLabels(labelOverlays, true));
+}
+
+std::vector<LabelLayerComponent::LabelBox> MediaDisplayComponent::layoutLabels(LabelIndex& index,
+                                                                               bool isOverlay)
+{
+    std::vector<LabelLayerComponent::LabelBox> boxes;
+
     float mediaWidth = getMediaWidth();
-    float mediaHeight = getMediaHeight();
+
+    if (mediaWidth <= 0.0f || getPixelsPerSecond() <= 0.0f
+        || index.getNumLabels(currentTempFileIdx) == 0)
+    {
+        return boxes;
+    }
+
+    Font labelFont(static_cast<float>(jmax(minFontSize, labelHeight - 2 * textSpacing)));
 
     float minLabelWidth = 0.1f * mediaWidth;
     float maxLabelWidth = 0.2f * mediaWidth;
 
-    auto positionLabels = [this, minLabelWidth, maxLabelWidth, mediaHeight](auto& labels)
-    {
-        for (auto l : labels)
-        {
-            if (l == nullptr)
-                continue;
+    // Columns are as wide as the narrowest label, so only a few labels fit in each
+    float columnWidth = jmax(1.0f, minLabelWidth);
+    int numColumns = static_cast<int>(std::ceil(mediaWidth / columnWidth));
 
-            float labelWidth = jmax(
-                minLabelWidth,
-                jmin(maxLabelWidth, l->getTextWidth() + 2.0f * static_cast<float>(textSpacing)));
+    size_t firstBoxInPreviousColumn = 0;
 
-            double labelStartTime = l->getTime();
-            double labelStopTime = labelStartTime + l->getDuration();
-            double labelCenterTime = labelStartTime + l->getDuration() / 2.0;
+    // Include one column beyond each edge for labels that are partially in view
+    for (int c = -1; c <= numColumns; ++c)
+    {
+        float columnX = static_cast<float>(c) * columnWidth;
 
-            float xPos =
-                correctMediaXBounds(timeToMediaX(labelCenterTime) - labelWidth / 2.0f, labelWidth);
-            float yPos = 1.0f;
+        Range<int> positions = index.findByCentreTime(
+            { mediaXToTime(columnX), mediaXToTime(columnX + columnWidth) }, currentTempFileIdx);
 
-            if (auto lo = dynamic_cast<LabelOverlayComponent*>(l))
+        size_t firstBoxInColumn = boxes.size();
+
+        if (positions.getLength() > maxLabelsPerColumn)
+        {
+            // First and last label of a band one label high, with the number of labels in it
+            struct Band
             {
-                yPos = lo->getRelativeY() * mediaHeight - static_cast<float>(labelHeight) / 2.0f;
-                yPos = jmin(mediaHeight - static_cast<float>(labelHeight), jmax(0.0f, yPos));
-                yPos = mediaYToDisplayY(yPos);
-            }
+                int firstIdx = 0;
+                int lastIdx = 0;
+                int numLabels = 0;
+            };
 
-            Rectangle<float> labelBounds(xPos, yPos, labelWidth, static_cast<float>(labelHeight));
-            l->setBounds(labelBounds.toNearestInt());
-            //l->toFront(true);
+            std::map<int, Band> bands;
 
-            float cursorRadius = cursorWidth / 2.0f;
+            // Labels of a band overlap, while those at other heights stay apart
+            for (int i = positions.getStart(); i < positions.getEnd(); ++i)
+            {
+                float y = getLabelBoxY(index.getLabel(i), isOverlay);
+                int bandIdx = static_cast<int>(std::floor(y / static_cast<float>(labelHeight)));
 
-            float leftLabelMarkerPos = static_cast<float>(
-                correctMediaXBounds(timeToMediaX(labelStartTime) - cursorRadius, cursorWidth));
-            l->setLeftMarkerBounds(
-                Rectangle<float>(leftLabelMarkerPos, 0, cursorWidth, mediaHeight).toNearestInt());
+                Band& band = bands[bandIdx];
 
-            float rightLabelMarkerPos = static_cast<float>(
-                correctMediaXBounds(timeToMediaX(labelStopTime) - cursorRadius, cursorWidth));
-            l->setRightMarkerBounds(
-                Rectangle<float>(rightLabelMarkerPos, 0, cursorWidth, mediaHeight).toNearestInt());
+                if (band.numLabels == 0)
+                {
+                    band.firstIdx = i;
+                }
 
-            float durationWidth = jmax(0.0f, rightLabelMarkerPos - leftLabelMarkerPos);
-            l->setDurationFillBounds(
-                Rectangle<float>(leftLabelMarkerPos + cursorRadius, 0, durationWidth, mediaHeight)
-                    .toNearestInt());
+                band.lastIdx = i;
+                ++band.numLabels;
+            }
 
-            if (l->getIndex() == currentTempFileIdx)
+            for (const auto& [bandIdx, band] : bands)
             {
-                l->setVisible(true);
+                LabelLayerComponent::LabelBox b = createLabelBox(index.getLabel(band.firstIdx),
+                                                                 isOverlay,
+                                                                 labelFont,
+                                                                 minLabelWidth,
+                                                                 maxLabelWidth);
+
+                if (band.numLabels > 1)
+                {
+                    LabelLayerComponent::LabelBox last =
+                        createLabelBox(index.getLabel(band.lastIdx),
+                                       isOverlay,
+                                       labelFont,
+                                       minLabelWidth,
+                                       maxLabelWidth);
+
+                    mergeLabelBoxes(b, last);
+
+                    b.numLabels = band.numLabels;
+                    b.text = String(b.numLabels) + " labels";
+                    b.description = b.text;
+                }
+
+                boxes.push_back(b);
             }
-            else
+        }
+        else
+        {
+            for (int i = positions.getStart(); i < positions.getEnd(); ++i)
             {
-                l->setVisible(false);
+                LabelLayerComponent::LabelBox b = createLabelBox(
+                    index.getLabel(i), isOverlay, labelFont, minLabelWidth, maxLabelWidth);
+
+                bool merged = false;
+
+                // Cluster with any overlapping box in this or the previous column
+                for (size_t j = firstBoxInPreviousColumn; j < boxes.size(); ++j)
+                {
+                    if (boxes[j].bounds.intersects(b.bounds))
+                    {
+                        mergeLabelBoxes(boxes[j], b);
+                        merged = true;
+                        break;
+                    }
+                }
+
+                if (! merged)
+                {
+                    boxes.push_back(b);
+                }
             }
         }
-    };
 
-    positionLabels(overheadLabels);
-    positionLabels(labelOverlays);
+        firstBoxInPreviousColumn = firstBoxInColumn;
+    }
+
+    return boxes;
+}
+
+LabelLayerComponent::LabelBox MediaDisplayComponent::createLabelBox(const DisplayLabel& l,
+                                                                    bool isOverlay,
+                                                                    const Font& labelFont,
+                                                                    float minLabelWidth,
+                                                                    float maxLabelWidth)
+{
+    LabelLayerComponent::LabelBox b;
+
+    b.text = l.text;
+    b.description = l.description;
+    b.color = l.color;
+    b.link = l.link;
+
+    float labelWidth =
+        jmax(minLabelWidth,
+             jmin(maxLabelWidth,
+                  labelFont.getStringWidthFloat(l.text) + 2.0f * static_cast<float>(textSpacing)));
+
+    double labelStartTime = l.time;
+    double labelStopTime = labelStartTime + l.duration;
+    double labelCenterTime = l.getCentreTime();
+
+    float xPos =
+        correctMediaXBounds(timeToMediaX(labelCenterTime) - labelWidth / 2.0f, labelWidth);
+    float yPos = getLabelBoxY(l, isOverlay);
+
+    b.bounds = Rectangle<float>(xPos, yPos, labelWidth, static_cast<float>(labelHeight));
+
+    float cursorRadius = cursorWidth / 2.0f;
+
+    float leftLabelMarkerPos = static_cast<float>(
+        correctMediaXBounds(timeToMediaX(labelStartTime) - cursorRadius, cursorWidth));
+    float rightLabelMarkerPos = static_cast<float>(
+        correctMediaXBounds(timeToMediaX(labelStopTime) - cursorRadius, cursorWidth));
+
+    b.markerRange = { leftLabelMarkerPos, jmax(leftLabelMarkerPos, rightLabelMarkerPos) };
+
+    return b;
+}
+
+float MediaDisplayComponent::getLabelBoxY(const DisplayLabel& l, bool isOverlay)
+{
+    if (! isOverlay)
+    {
+        return 1.0f;
+    }
+
+    float mediaHeight = getMediaHeight();
+
+    float yPos = l.relativeY * mediaHeight - static_cast<float>(labelHeight) / 2.0f;
+    yPos = jmin(mediaHeight - static_cast<float>(labelHeight), jmax(0.0f, yPos));
+
+    return mediaYToDisplayY(yPos);
+}
+
+void MediaDisplayComponent::mergeLabelBoxes(LabelLayerComponent::LabelBox& target,
+                                            const LabelLayerComponent::LabelBox& other)
+{
+    // Clusters only grow horizontally, so they stay one label high
+    Rectangle<float> u = target.bounds.getUnion(other.bounds);
+    target.bounds = target.bounds.withX(u.getX()).withWidth(u.getWidth());
+    target.markerRange = target.markerRange.getUnionWith(other.markerRange);
+    target.numLabels += other.numLabels;
+
+    target.text = String(target.numLabels) + " labels";
+    target.description = target.text;
+    target.link = String();
+}
+
+void MediaDisplayComponent::setLabelMarkers(const LabelLayerComponent::LabelBox* b)
+{
+    // Markers span the media area, which is covered by the overlay layer
+    if (b != nullptr)
+    {
+        overlayLabelLayer.setMarkers(b->markerRange, b->color);
+    }
+    else
+    {
+        overlayLabelLayer.clearMarkers();
+    }
 }
 
 void MediaDisplayComponent::timerCallback()
@@ -397,6 +624,11 @@ void MediaDisplayComponent::timerCallback()
     if (isPlaying())
     {
         updateCursorPosition();
+
+        if (auto* gauge = getAudioLoadGauge())
+        {
+            gauge->set(deviceManager.getCpuUsage());
+        }
     }
     else
     {
@@ -413,6 +645,7 @@ void MediaDisplayComponent::setTrackName(String name)
 
 void MediaDisplayComponent::resetDisplay()
 {
+    cancelLoading();
     clearLabels();
     resetMedia();
     resetPaths();
@@ -422,9 +655,13 @@ void MediaDisplayComponent::resetDisplay()
 
 void MediaDisplayComponent::resetPaths()
 {
+    WorkspaceManager::getInstance()->release(originalFilePath.getLocalFile());
+
     originalFilePath = URL();
 
-    tempFilePaths.clear();
+    setActiveEntry(nullptr);
+
+    historySteps.clear();
     currentTempFileIdx = -1;
 }
 
@@ -453,21 +690,80 @@ void MediaDisplayComponent::initializeDisplay(const URL& filePath)
     resetDisplay();
 
     setOriginalFilePath(filePath);
-    updateDisplay(filePath);
-
-    if (! isThumbnailTrack())
-    {
-        horizontalScrollBar.setVisible(true);
-    }
-    updateVisibleRange({ 0.0, getTotalLengthInSecs() });
-    resized(); // Needed to display scrollbar after loading
+    startLoading(filePath, true);
 }
 
-void MediaDisplayComponent::updateDisplay(const URL& filePath)
+void MediaDisplayComponent::updateDisplay(const URL& filePath) { startLoading(filePath, false); }
+
+void MediaDisplayComponent::startLoading(const URL& filePath, bool isNewDisplay)
 {
+    // Supersede any load still in progress
+    cancelLoading();
+
     resetMedia();
 
-    loadMediaFile(filePath);
+    auto loadState = std::make_shared<MediaLoadState>();
+
+    currentLoadState = loadState;
+    loadingOverlay.startLoading(loadState);
+
+    MediaPreparer prepare = createMediaPreparer(filePath);
+    SafePointer<MediaDisplayComponent> safeThis(this);
+
+    scheduler->submit(
+        TaskScheduler::Lane::Interactive,
+        [prepare, loadState, safeThis, filePath, isNewDisplay]
+        {
+            // Superseded while still queued
+            if (loadState->shouldCancel())
+            {
+                return;
+            }
+
+            std::shared_ptr<PreparedMedia> media;
+
+            {
+                HARP_TRACE_SCOPE("media", "MediaDisplayComponent::prepareMedia");
+
+                media = prepare(*loadState);
+            }
+
+            if (loadState->shouldCancel())
+            {
+                return;
+            }
+
+            MessageManager::callAsync(
+                [media, loadState, safeThis, filePath, isNewDisplay]
+                {
+                    // Display was destroyed or another load started in the meantime
+                    if (safeThis == nullptr || loadState->shouldCancel())
+                    {
+                        return;
+                    }
+
+                    safeThis->finishLoading(filePath, media.get(), isNewDisplay);
+                });
+        });
+}
+
+void MediaDisplayComponent::finishLoading(const URL& filePath,
+                                          PreparedMedia* media,
+                                          bool isNewDisplay)
+{
+    HARP_TRACE_SCOPE("media", "MediaDisplayComponent::finishLoading");
+
+    currentLoadState.reset();
+    loadingOverlay.stopLoading();
+
+    if (media == nullptr)
+    {
+        DBG("MediaDisplayComponent::finishLoading: Failed to load file "
+            << filePath.getLocalFile().getFullPathName() << ".");
+        return;
+    }
+
+    loadMediaFile(filePath, *media);
     postLoadActions(filePath);
 
     currentPositionCursor.toFront(true);
@@ -478,73 +774,95 @@ void MediaDisplayComponent::updateDisplay(const URL& filePath)
 
     playStopButton.setMode(playButtonActiveInfo.label);
     saveFileButton.setMode(saveFileButtonActiveInfo.label);
+
+    if (isNewDisplay)
+    {
+        if (! isThumbnailTrack())
+        {
+            horizontalScrollBar.setVisible(true);
+        }
+        updateVisibleRange({ 0.0, getTotalLengthInSecs() });
+        resized(); // Needed to display scrollbar after loading
+    }
+}
+
+void MediaDisplayComponent::cancelLoading()
+{
+    if (currentLoadState != nullptr)
+    {
+        currentLoadState->cancelled = true;
+        currentLoadState.reset();
+    }
+
+    loadingOverlay.stopLoading();
 }
 
 void MediaDisplayComponent::setOriginalFilePath(URL filePath)
 {
+    // Keeps downloaded files from being evicted while they are shown
+    WorkspaceManager::getInstance()->release(originalFilePath.getLocalFile());
+
     originalFilePath = filePath;
 
-    //addNewTempFile();
+    WorkspaceManager::getInstance()->retain(originalFilePath.getLocalFile());
 }
 
-/*void MediaDisplayComponent::addNewTempFile()
+void MediaDisplayComponent::addNewTempFile(const URL& filePath)
 {
-    // Prune any future files in chain before adding new temp file
+    // Prune any future steps in chain before adding the new one
     clearFutureTempFiles();
 
-    int numTempFiles = tempFilePaths.size();
+    historySteps.push_back({ filePath, nullptr });
+    currentTempFileIdx = static_cast<int>(historySteps.size()) - 1;
 
-    // Obtain original file used to initialize display
-    File originalFile = originalFilePath.getLocalFile();
+    bool isNewDisplay = ! isFileLoaded();
 
-    File targetFile; // File to copy to new temp file
+    setActiveEntry(nullptr);
+    setOriginalFilePath(filePath);
+    startLoading(filePath, isNewDisplay);
 
-    if (! numTempFiles)
-    {
-        // Copy original file if no temp files
-        targetFile = originalFile;
-    }
-    else
-    {
-        // Otherwise copy most recent temp file
-        targetFile = getTempFilePath().getLocalFile();
-    }
+    // Step shows the file directly until it has been added to the store
+    int stepIdx = currentTempFileIdx;
+    SafePointer<MediaDisplayComponent> safeThis(this);
 
-    String tempDirectory =
-        File::getSpecialLocation(File::SpecialLocationType::tempDirectory).getFullPathName();
+    historyStore->addAsync(
+        filePath.getLocalFile(),
+        [safeThis, stepIdx, filePath](MediaHistoryStore::EntryPtr entry)
+        {
+            if (safeThis == nullptr || entry == nullptr)
+            {
+                return;
+            }
 
-    String targetFileName = originalFile.getFileNameWithoutExtension();
-    String targetFileExtension = originalFile.getFileExtension();
+            auto& steps = safeThis->historySteps;
 
-    URL tempFilePath = URL(File(tempDirectory + "/HARP/" + targetFileName + "_"
-                                + String(numTempFiles) + targetFileExtension));
+            // Step may have been pruned in the meantime
+            if (stepIdx < 0 || static_cast<size_t>(stepIdx) >= steps.size())
+            {
+                return;
+            }
 
-    File tempFile = tempFilePath.getLocalFile();
+            HistoryStep& step = steps[static_cast<size_t>(stepIdx)];
 
-    tempFile.getParentDirectory().createDirectory();
+            if (step.filePath != filePath)
+            {
+                return;
+            }
 
-    if (! targetFile.copyFileTo(tempFile))
-    {
-        DBG("MediaDisplayComponent::addNewTempFile: Failed to copy file "
-            << targetFile.getFullPathName() << " to " << tempFile.getFullPathName() << ".");
-    }
-    else
-    {
-        DBG("MediaDisplayComponent::addNewTempFile: Copied file "
-            << targetFile.getFullPathName() << " to " << tempFile.getFullPathName() << ".");
-    }
+            step.entry = entry;
 
-    tempFilePaths.add(tempFilePath);
-    currentTempFileIdx++;
+            if (stepIdx == safeThis->currentTempFileIdx)
+            {
+                safeThis->setActiveEntry(entry);
+            }
+        });
 }
 
 bool MediaDisplayComponent::iteratePreviousTempFile()
 {
     if (currentTempFileIdx > 0)
     {
-        currentTempFileIdx--;
-
-        updateDisplay(getTempFilePath());
+        showHistoryStep(currentTempFileIdx - 1);
 
         return true;
     }
@@ -556,11 +874,9 @@ bool MediaDisplayComponent::iteratePreviousTempFile()
 
 bool MediaDisplayComponent::iterateNextTempFile()
 {
-    if (currentTempFileIdx + 1 < tempFilePaths.size())
+    if (currentTempFileIdx + 1 < static_cast<int>(historySteps.size()))
     {
-        currentTempFileIdx++;
-
-        updateDisplay(getTempFilePath());
+        showHistoryStep(currentTempFileIdx + 1);
 
         return true;
     }
@@ -572,14 +888,67 @@ bool MediaDisplayComponent::iterateNextTempFile()
 
 void MediaDisplayComponent::clearFutureTempFiles()
 {
-    int n = tempFilePaths.size() - (currentTempFileIdx + 1);
-
-    tempFilePaths.removeLast(n);
+    historySteps.resize(static_cast<size_t>(currentTempFileIdx + 1));
 
     clearLabels(currentTempFileIdx + 1);
 }
 
-void MediaDisplayComponent::overwriteOriginalFile()
+void MediaDisplayComponent::showHistoryStep(int stepIdx)
+{
+    currentTempFileIdx = stepIdx;
+
+    // Labels of the step
+    resized();
+    repositionLabels();
+
+    const HistoryStep& step = historySteps[static_cast<size_t>(stepIdx)];
+
+    if (step.entry == nullptr)
+    {
+        setActiveEntry(nullptr);
+        setOriginalFilePath(step.filePath);
+        updateDisplay(step.filePath);
+
+        return;
+    }
+
+    SafePointer<MediaDisplayComponent> safeThis(this);
+
+    // Compressed entries are restored first
+    setActiveEntry(step.entry,
+                   [safeThis, stepIdx](const File& file)
+                   {
+                       if (safeThis == nullptr || safeThis->currentTempFileIdx != stepIdx
+                           || file == File())
+                       {
+                           return;
+                       }
+
+                       safeThis->setOriginalFilePath(URL(file));
+                       safeThis->updateDisplay(URL(file));
+                   });
+}
+
+void MediaDisplayComponent::setActiveEntry(MediaHistoryStore::EntryPtr entry,
+                                           std::function<void(const File&)> onActivated)
+{
+    MediaHistoryStore::EntryPtr previousEntry = activeEntry;
+
+    activeEntry = entry;
+
+    // Activated before the previous one is released, so a shared entry is never compressed
+    if (activeEntry != nullptr)
+    {
+        historyStore->activateAsync(activeEntry, onActivated);
+    }
+
+    if (previousEntry != nullptr)
+    {
+        historyStore->deactivate(previousEntry);
+    }
+}
+
+/*void MediaDisplayComponent::overwriteOriginalFile()
 {
     File targetFile = originalFilePath.getLocalFile();
     File tempFile = getTempFilePath().getLocalFile();
@@ -712,31 +1081,54 @@ void MediaDisplayComponent::saveFileCallback()
                                 unlinkFromDAW();
                             }
 
+                            SafePointer<MediaDisplayComponent> safeThis(this);
+
                             // Attempt to save file contained within media display to chosen location
                             //bool saveSuccessful = tempFilePath.getLocalFile().copyFileTo(newFile);
-                            if (getOriginalFilePath().getLocalFile().copyFileTo(chosenFile))
-                            {
-                                //loadMediaDisplay(newFile);
-
-                                // Update path associated with media display
-                                setOriginalFilePath(URL(chosenFile));
-
-                                //saveFileButton.setMode(saveButtonInactiveInfo.label);
-
-                                if (statusBox != nullptr)
+                            fileMaterializer->materializeAsync(
+                                getOriginalFilePath().getLocalFile(),
+                                chosenFile,
+                                [safeThis, chosenFile](double progress)
                                 {
-                                    statusBox->setStatusMessage("File successfully saved to "
-                                                                + chosenFile.getFullPathName());
-                                }
-                            }
-                            else
-                            {
-                                AlertWindow::showMessageBoxAsync(
-                                    AlertWindow::WarningIcon,
-                                    "Save Failed",
-                                    "Failed to save file to " + chosenFile.getFullPathName() + ".",
-                                    "OK");
-                            }
+                                    if (safeThis != nullptr && safeThis->statusBox != nullptr)
+                                    {
+                                        safeThis->statusBox->setStatusMessage(
+                                            "Saving file to " + chosenFile.getFullPathName() + " ("
+                                            + String(roundToInt(progress * 100.0)) + "%)...");
+                                    }
+                                },
+                                [safeThis, chosenFile](bool saveSuccessful)
+                                {
+                                    if (! saveSuccessful)
+                                    {
+                                        AlertWindow::showMessageBoxAsync(
+                                            AlertWindow::WarningIcon,
+                                            "Save Failed",
+                                            "Failed to save file to " + chosenFile.getFullPathName()
+                                                + ".",
+                                            "OK");
+                                        return;
+                                    }
+
+                                    if (safeThis == nullptr)
+                                    {
+                                        return;
+                                    }
+
+                                    //loadMediaDisplay(newFile);
+
+                                    // Update path associated with media display
+                                    safeThis->setOriginalFilePath(URL(chosenFile));
+
+                                    //saveFileButton.setMode(saveButtonInactiveInfo.label);
+
+                                    if (safeThis->statusBox != nullptr)
+                                    {
+                                        safeThis->statusBox->setStatusMessage(
+                                            "File successfully saved to "
+                                            + chosenFile.getFullPathName());
+                                    }
+                                });
                         }
                         else
                         {
@@ -966,8 +1358,30 @@ void MediaDisplayComponent::deselectTrack()
     }
 }
 
+void MediaDisplayComponent::openAudioDevice()
+{
+    if (audioDeviceOpened)
+    {
+        return;
+    }
+
+    String error = deviceManager.initialise(0, 2, nullptr, true, {}, nullptr);
+
+    if (error.isNotEmpty())
+    {
+        DBG("MediaDisplayComponent::openAudioDevice: Failed to open audio device: " << error
+                                                                                   << ".");
+    }
+
+    deviceManager.addAudioCallback(&sourcePlayer);
+
+    audioDeviceOpened = true;
+}
+
 void MediaDisplayComponent::start()
 {
+    openAudioDevice();
+
     startPlaying();
 
     startTimerHz(40);
@@ -981,6 +1395,11 @@ void MediaDisplayComponent::stop()
 
     stopTimer();
 
+    if (auto* gauge = getAudioLoadGauge())
+    {
+        gauge->set(0.0);
+    }
+
     currentPositionCursor.setVisible(false);
     setPlaybackPosition(0.0);
 
@@ -1121,63 +1540,7 @@ void MediaDisplayComponent::mouseDoubleClick(const MouseEvent& e)
 
 int MediaDisplayComponent::getNumOverheadLabels()
 {
-    int nOverheadLabels = 0;
-
-    for (auto l : overheadLabels)
-    {
-        if (l->getIndex() == currentTempFileIdx)
-        {
-            nOverheadLabels++;
-        }
-    }
-
-    return nOverheadLabels;
-}
-
-void MediaDisplayComponent::addOverheadLabel(OverheadLabelComponent* l)
-{
-    l->setFont(Font(jmax(minFontSize, labelHeight - 2 * textSpacing)));
-    l->setIndex(currentTempFileIdx);
-    overheadLabels.add(l);
-
-    Component* mediaComponentPtr = getMediaComponent();
-    l->addMarkersTo(mediaComponentPtr);
-    overheadPanel.addAndMakeVisible(l);
-
-    resized(); // Needed to make panel and labels visible
-}
-
-void MediaDisplayComponent::removeOverheadLabel(OverheadLabelComponent* l)
-{
-    Component* mediaComponentPtr = getMediaComponent();
-
-    l->removeMarkersFrom(mediaComponentPtr);
-    overheadPanel.removeChildComponent(l);
-
-    overheadLabels.removeObject(l);
-}
-
-void MediaDisplayComponent::addLabelOverlay(LabelOverlayComponent* l)
-{
-    l->setFont(Font(jmax(minFontSize, labelHeight - 2 * textSpacing)));
-    l->setIndex(currentTempFileIdx);
-    labelOverlays.add(l);
-
-    Component* mediaComponentPtr = getMediaComponent();
-    l->addMarkersTo(mediaComponentPtr);
-    mediaComponentPtr->addAndMakeVisible(l);
-
-    repositionLabels(); // Needed to make labels visible
-}
-
-void MediaDisplayComponent::removeLabelOverlay(LabelOverlayComponent* l)
-{
-    Component* mediaComponentPtr = getMediaComponent();
-
-    l->removeMarkersFrom(mediaComponentPtr);
-    mediaComponentPtr->removeChildComponent(l);
-
-    labelOverlays.removeObject(l);
+    return overheadLabels.getNumLabels(currentTempFileIdx);
 }
 
 void MediaDisplayComponent::addLabels(LabelList& labels)
@@ -1189,31 +1552,33 @@ void MediaDisplayComponent::addLabels(LabelList& labels)
             continue;
         }
 
-        std::unique_ptr<OutputLabelComponent> lc =
-            std::make_unique<OutputLabelComponent>((double) l->t, l->label);
+        DisplayLabel dl;
+
+        dl.time = static_cast<double>(l->t);
+        dl.text = l->label;
+        dl.description = l->label;
+        dl.processingIndex = currentTempFileIdx;
 
-        if ((l->description).has_value())
+        if ((l->description).has_value() && (l->description).value().isNotEmpty())
         {
-            lc->setDescription((l->description).value());
+            dl.description = (l->description).value();
         }
 
         if ((l->duration).has_value())
         {
-            lc->setDuration(static_cast<double>((l->duration).value()));
+            dl.duration = static_cast<double>((l->duration).value());
         }
 
         if ((l->color).has_value())
         {
-            lc->setColor(Colour(static_cast<uint32_t>((l->color).value())));
+            dl.color = Colour(static_cast<uint32_t>((l->color).value()));
         }
 
         if ((l->link).has_value())
         {
-            lc->setLink((l->link).value());
+            dl.link = (l->link).value();
         }
 
-        float y = 0.0f;
-
         bool isOverlay = false;
 
         if (auto audioLabel = dynamic_cast<AudioLabel*>(l.get()))
@@ -1224,7 +1589,19 @@ void MediaDisplayComponent::addLabels(LabelList& labels)
 
                 float amp = (audioLabel->amplitude).value();
 
-                y = LabelOverlayComponent::amplitudeToRelativeY(amp);
+                dl.relativeY = LabelLayerComponent::amplitudeToRelativeY(amp);
+            }
+        }
+
+        if (auto spectrogramLabel = dynamic_cast<SpectrogramLabel*>(l.get()))
+        {
+            if ((spectrogramLabel->frequency).has_value())
+            {
+                isOverlay = true;
+
+                float f = (spectrogramLabel->frequency).value();
+
+                dl.relativeY = LabelLayerComponent::frequencyToRelativeY(f);
             }
         }
 
@@ -1236,56 +1613,39 @@ void MediaDisplayComponent::addLabels(LabelList& labels)
 
                 float p = (midiLabel->pitch).value();
 
-                y = LabelOverlayComponent::pitchToRelativeY(p);
+                dl.relativeY = LabelLayerComponent::pitchToRelativeY(p);
             }
         }
 
         if (isOverlay)
         {
-            auto* lo = new LabelOverlayComponent(*static_cast<LabelOverlayComponent*>(lc.get()));
-            lo->setRelativeY(y);
-
-            addLabelOverlay(lo);
+            labelOverlays.add(dl);
         }
         else
         {
-            auto* ol = new OverheadLabelComponent(*static_cast<OverheadLabelComponent*>(lc.get()));
-            addOverheadLabel(ol);
+            overheadLabels.add(dl);
         }
     }
+
+    resized(); // Needed to make panel visible
+    repositionLabels(); // Needed to make labels visible
 }
 
 void MediaDisplayComponent::clearLabels(int processingIdxCutoff)
 {
-    for (int i = labelOverlays.size() - 1; i >= 0; --i)
-    {
-        LabelOverlayComponent* l = labelOverlays[i];
-
-        if (l->getIndex() >= processingIdxCutoff)
-        {
-            removeLabelOverlay(l);
-        }
-    }
-
     if (! processingIdxCutoff)
     {
         labelOverlays.clear();
+        overheadLabels.clear();
     }
-
-    for (int i = overheadLabels.size() - 1; i >= 0; --i)
+    else
     {
-        OverheadLabelComponent* l = overheadLabels[i];
-
-        if (l->getIndex() >= processingIdxCutoff)
-        {
-            removeOverheadLabel(l);
-        }
+        labelOverlays.removeFrom(processingIdxCutoff);
+        overheadLabels.removeFrom(processingIdxCutoff);
     }
 
-    if (! processingIdxCutoff)
-    {
-        overheadLabels.clear();
-    }
+    setLabelMarkers(nullptr);
+    repositionLabels();
 
     resized(); // Remove overhead label panel
 }
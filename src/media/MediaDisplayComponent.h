@@ -4,9 +4,14 @@
 #include "juce_gui_basics/juce_gui_basics.h"
 #include <juce_audio_utils/juce_audio_utils.h>
 
+#include "../FileMaterializer.h"
+#include "../TaskScheduler.h"
 #include "../gui/MultiButton.h"
 #include "../utils.h"
-#include "OutputLabelComponent.h"
+#include "LabelIndex.h"
+#include "LabelLayerComponent.h"
+#include "MediaHistoryStore.h"
+#include "MediaLoader.h"
 
 using namespace juce;
 
@@ -71,22 +76,24 @@ public:
     void setMediaInstructions(String instructions) { mediaInstructions = instructions; }
 
     void resetDisplay(); // Reset all state and media
-    void initializeDisplay(const URL& filePath); // Initialize new display
-    void updateDisplay(const URL& filePath); // Add new file to existing display
+    void initializeDisplay(const URL& filePath); // Initialize new display (asynchronously)
+    void updateDisplay(const URL& filePath); // Add new file to existing display (asynchronously)
 
-    virtual void loadMediaFile(const URL& filePath) = 0;
+    bool isLoading() const { return currentLoadState != nullptr; }
 
     URL getOriginalFilePath() { return originalFilePath; }
 
-    //void addNewTempFile(); // Create working temp file to modify instead of current or original
-    //bool iteratePreviousTempFile();
-    //bool iterateNextTempFile();
+    // File sent to models as this track's input
+    virtual File getFileForUpload() { return originalFilePath.getLocalFile(); }
+
+    // Show a processing result as a new step of the track's history (asynchronously)
+    void addNewTempFile(const URL& filePath);
+    bool iteratePreviousTempFile();
+    bool iterateNextTempFile();
 
-    //bool isFileLoaded() { return ! tempFilePaths.isEmpty(); }
     bool isFileLoaded() { return ! originalFilePath.isEmpty(); }
-    //URL getTempFilePath() { return tempFilePaths.getReference(currentTempFileIdx); }
 
-    //void clearFutureTempFiles(); // Prune temp files after currently selected index
+    void clearFutureTempFiles(); // Prune history steps after the currently shown one
     //void overwriteOriginalFile(); // Necessary for seamless sample editing integration
 
     bool isInterestedInFileDrag(const StringArray& /*files*/) override { return isInputTrack(); }
@@ -113,12 +120,6 @@ public:
 
     int getNumOverheadLabels();
 
-    void addOverheadLabel(OverheadLabelComponent* l);
-    void removeOverheadLabel(OverheadLabelComponent* l);
-
-    void addLabelOverlay(LabelOverlayComponent* l);
-    void removeLabelOverlay(LabelOverlayComponent* l);
-
     void addLabels(LabelList& labels);
     void clearLabels(int processingIdxCutoff = 0);
 
@@ -142,6 +143,10 @@ protected:
     AudioFormatManager formatManager;
     AudioDeviceManager deviceManager;
 
+    // Opening a device is slow, so it is deferred until the track is first played
+    void openAudioDevice();
+    bool audioDeviceOpened = false;
+
     AudioSourcePlayer sourcePlayer;
     AudioTransportSource transportSource;
 
@@ -159,8 +164,20 @@ private:
 
     void setOriginalFilePath(URL filePath);
 
+    void showHistoryStep(int stepIdx);
+    void setActiveEntry(MediaHistoryStore::EntryPtr entry,
+                        std::function<void(const File&)> onActivated = [](const File&) {});
+
+    // Create the part of loading a file that runs on a worker thread
+    virtual MediaPreparer createMediaPreparer(const URL& filePath) = 0;
+    // Swap prepared media into the display
+    virtual void loadMediaFile(const URL& filePath, PreparedMedia& media) = 0;
     virtual void postLoadActions(const URL& filePath) = 0;
 
+    void startLoading(const URL& filePath, bool isNewDisplay);
+    void finishLoading(const URL& filePath, PreparedMedia* media, bool isNewDisplay);
+    void cancelLoading();
+
     void filesDropped(const StringArray& files, int /*x*/, int /*y*/) override;
 
     void chooseFileCallback();
@@ -200,9 +217,22 @@ private:
 
     virtual bool shouldRenderLabel(const std::unique_ptr<OutputLabel>& /*l*/) const { return true; }
 
+    std::vector<LabelLayerComponent::LabelBox> layoutLabels(LabelIndex& index, bool isOverlay);
+    LabelLayerComponent::LabelBox createLabelBox(const DisplayLabel& l,
+                                                 bool isOverlay,
+                                                 const Font& labelFont,
+                                                 float minLabelWidth,
+                                                 float maxLabelWidth);
+    float getLabelBoxY(const DisplayLabel& l, bool isOverlay);
+    void mergeLabelBoxes(LabelLayerComponent::LabelBox& target,
+                         const LabelLayerComponent::LabelBox& other);
+    void setLabelMarkers(const LabelLayerComponent::LabelBox* b);
+
     const int textSpacing = 2;
     const int minFontSize = 10;
     const int labelHeight = 20;
+    // Beyond this, labels in one column are summarized by height instead of laid out individually
+    const int maxLabelsPerColumn = 8;
 
     Colour defaultColor = Colours::darkgrey;
     Colour graphicsColor = Colours::lightblue;
@@ -251,8 +281,24 @@ private:
     bool isSelected = false;
 
     URL originalFilePath;
+
+    struct HistoryStep
+    {
+        URL filePath;
+
+        // Null until the file has been added to the store
+        MediaHistoryStore::EntryPtr entry;
+    };
+
+    // Processing results shown by the track, labels are kept by the index of their step
+    std::vector<HistoryStep> historySteps;
     int currentTempFileIdx;
-    Array<URL> tempFilePaths;
+
+    // Store entry of the step currently shown, if any
+    MediaHistoryStore::EntryPtr activeEntry;
+    SharedResourcePointer<MediaHistoryStore> historyStore;
+
+    SharedResourcePointer<FileMaterializer> fileMaterializer;
 
     std::unique_ptr<FileChooser> chooseFileBrowser;
     std::unique_ptr<FileChooser> saveFileBrowser;
@@ -263,11 +309,19 @@ private:
     const float cursorWidth = 1.5f;
     DrawableRectangle currentPositionCursor;
 
-    OwnedArray<LabelOverlayComponent> labelOverlays;
-    OwnedArray<OverheadLabelComponent> overheadLabels;
+    LabelIndex labelOverlays;
+    LabelIndex overheadLabels;
+
+    LabelLayerComponent overlayLabelLayer;
+    LabelLayerComponent overheadLabelLayer;
 
     bool isLabelRepositioningScheduled = false;
 
+    // State of the load in progress, if any
+    std::shared_ptr<MediaLoadState> currentLoadState;
+    MediaLoadingOverlay loadingOverlay;
+    SharedResourcePointer<TaskScheduler> scheduler;
+
     SharedResourcePointer<InstructionBox> instructionBox;
     SharedResourcePointer<StatusBox> statusBox;
 };
@@ -0,0 +1,308 @@
+#include "MediaHistoryStore.h"
+
+#include "../FileMaterializer.h"
+#include "../TraceRecorder.h"
+#include "../WorkspaceManager.h"
+
+MediaHistoryStore::Entry::~Entry()
+{
+    file.deleteFile();
+    compressedFile.deleteFile();
+}
+
+MediaHistoryStore::MediaHistoryStore()
+{
+    storeDirectory = WorkspaceManager::getInstance()->getSessionDirectory().getChildFile("history");
+
+    Result result = storeDirectory.createDirectory();
+
+    if (result.failed())
+    {
+        DBG("MediaHistoryStore::MediaHistoryStore: Failed to create store directory "
+            << storeDirectory.getFullPathName() << ": " << result.getErrorMessage() << ".");
+    }
+}
+
+MediaHistoryStore::EntryPtr MediaHistoryStore::add(const File& sourceFile)
+{
+    HARP_TRACE_SCOPE("media", "MediaHistoryStore::add");
+
+    if (! sourceFile.existsAsFile())
+    {
+        return nullptr;
+    }
+
+    String extension = sourceFile.getFileExtension().toLowerCase();
+    String key = SHA256(sourceFile).toHexString() + extension;
+
+    std::lock_guard<std::mutex> sl(entriesLock);
+
+    if (auto it = entries.find(key); it != entries.end())
+    {
+        if (EntryPtr existingEntry = it->second.lock())
+        {
+            return existingEntry;
+        }
+
+        entries.erase(it);
+    }
+
+    auto entry = std::make_shared<Entry>();
+
+    // Unique per entry, so a new entry never collides with an expired one still being deleted
+    entry->file = storeDirectory.getChildFile(Uuid().toString() + extension);
+    entry->compressedFile = entry->file.withFileExtension(".flac");
+
+    if (! cloneOrLink(sourceFile, entry->file))
+    {
+        DBG("MediaHistoryStore::add: Failed to store file " << sourceFile.getFullPathName()
+                                                            << ".");
+        return nullptr;
+    }
+
+    entries[key] = entry;
+
+    return entry;
+}
+
+void MediaHistoryStore::addAsync(const File& sourceFile, std::function<void(EntryPtr)> onAdded)
+{
+    // Holding a reference keeps the store alive until the file is added
+    SharedResourcePointer<MediaHistoryStore> store;
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    scheduler->submit(TaskScheduler::Lane::Background,
+                      [store, sourceFile, onAdded]
+                      {
+                          EntryPtr entry = store->add(sourceFile);
+
+                          MessageManager::callAsync([entry, onAdded] { onAdded(entry); });
+                      });
+}
+
+void MediaHistoryStore::activateAsync(EntryPtr entry,
+                                      std::function<void(const File&)> onActivated)
+{
+    bool needsRestore;
+
+    {
+        std::lock_guard<std::mutex> sl(entry->lock);
+
+        entry->numActive++;
+        needsRestore = entry->isCompressed;
+    }
+
+    if (! needsRestore)
+    {
+        onActivated(entry->getFile());
+        return;
+    }
+
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    // A track is waiting on it
+    scheduler->submit(TaskScheduler::Lane::Interactive,
+                      [entry, onActivated]
+                      {
+                          File restoredFile = restore(*entry) ? entry->getFile() : File();
+
+                          MessageManager::callAsync([restoredFile, onActivated]
+                                                    { onActivated(restoredFile); });
+                      });
+}
+
+void MediaHistoryStore::deactivate(EntryPtr entry)
+{
+    {
+        std::lock_guard<std::mutex> sl(entry->lock);
+
+        jassert(entry->numActive > 0);
+
+        if (--entry->numActive > 0 || entry->isCompressed)
+        {
+            return;
+        }
+    }
+
+    // Only lossless for integer PCM, which compress() checks
+    if (! entry->file.hasFileExtension("wav"))
+    {
+        return;
+    }
+
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    scheduler->submit(TaskScheduler::Lane::Background, [entry] { compress(entry); });
+}
+
+bool MediaHistoryStore::cloneOrLink(const File& sourceFile, const File& targetFile)
+{
+    // Outputs are never modified in place, so sharing the inode is safe
+    if (FileMaterializer::clone(sourceFile, targetFile)
+        || FileMaterializer::link(sourceFile, targetFile))
+    {
+        return true;
+    }
+
+    // E.g., across file systems
+    return sourceFile.copyFileTo(targetFile);
+}
+
+void MediaHistoryStore::compress(EntryPtr entry)
+{
+    HARP_TRACE_SCOPE("media", "MediaHistoryStore::compress");
+
+    WavAudioFormat wavFormat;
+    FlacAudioFormat flacFormat;
+
+    std::unique_ptr<AudioFormatReader> reader(
+        wavFormat.createReaderFor(entry->file.createInputStream().release(), true));
+
+    // FLAC only stores integer samples up to 24 bits losslessly
+    if (reader == nullptr || reader->usesFloatingPointData || reader->bitsPerSample > 24)
+    {
+        return;
+    }
+
+    File partialFile = entry->file.getSiblingFile(Uuid().toString() + ".part");
+
+    {
+        auto stream = partialFile.createOutputStream();
+
+        if (stream == nullptr)
+        {
+            return;
+        }
+
+        std::unique_ptr<AudioFormatWriter> writer(
+            flacFormat.createWriterFor(stream.get(),
+                                       reader->sampleRate,
+                                       reader->numChannels,
+                                       static_cast<int>(reader->bitsPerSample),
+                                       {},
+                                       0));
+
+        if (writer == nullptr)
+        {
+            partialFile.deleteFile();
+            return;
+        }
+
+        // Writer owns the stream from here on
+        stream.release();
+
+        if (! writer->writeFromAudioReader(*reader, 0, -1))
+        {
+            writer.reset();
+            partialFile.deleteFile();
+            return;
+        }
+    }
+
+    StringPairArray metadata = reader->metadataValues;
+    reader.reset();
+
+    std::lock_guard<std::mutex> sl(entry->lock);
+
+    // Shown again in the meantime
+    if (entry->numActive > 0 || entry->isCompressed || ! partialFile.moveFileTo(entry->compressedFile))
+    {
+        partialFile.deleteFile();
+        return;
+    }
+
+    // Fails (e.g., on Windows) while a track still has the file mapped
+    if (! entry->file.deleteFile())
+    {
+        entry->compressedFile.deleteFile();
+        return;
+    }
+
+    entry->metadata = metadata;
+    entry->isCompressed = true;
+}
+
+bool MediaHistoryStore::restore(Entry& entry)
+{
+    HARP_TRACE_SCOPE("media", "MediaHistoryStore::restore");
+
+    StringPairArray metadata;
+
+    {
+        std::lock_guard<std::mutex> sl(entry.lock);
+
+        // Restored by another track in the meantime
+        if (! entry.isCompressed)
+        {
+            return true;
+        }
+
+        metadata = entry.metadata;
+    }
+
+    WavAudioFormat wavFormat;
+    FlacAudioFormat flacFormat;
+
+    std::unique_ptr<AudioFormatReader> reader(
+        flacFormat.createReaderFor(entry.compressedFile.createInputStream().release(), true));
+
+    if (reader == nullptr)
+    {
+        return false;
+    }
+
+    File partialFile = entry.file.getSiblingFile(Uuid().toString() + ".part");
+
+    {
+        auto stream = partialFile.createOutputStream();
+
+        if (stream == nullptr)
+        {
+            return false;
+        }
+
+        std::unique_ptr<AudioFormatWriter> writer(
+            wavFormat.createWriterFor(stream.get(),
+                                      reader->sampleRate,
+                                      reader->numChannels,
+                                      static_cast<int>(reader->bitsPerSample),
+                                      metadata,
+                                      0));
+
+        if (writer == nullptr)
+        {
+            partialFile.deleteFile();
+            return false;
+        }
+
+        stream.release();
+
+        if (! writer->writeFromAudioReader(*reader, 0, -1))
+        {
+            writer.reset();
+            partialFile.deleteFile();
+            return false;
+        }
+    }
+
+    reader.reset();
+
+    std::lock_guard<std::mutex> sl(entry.lock);
+
+    if (! entry.isCompressed)
+    {
+        partialFile.deleteFile();
+        return true;
+    }
+
+    if (! partialFile.moveFileTo(entry.file))
+    {
+        partialFile.deleteFile();
+        return false;
+    }
+
+    entry.compressedFile.deleteFile();
+    entry.isCompressed = false;
+
+    return true;
+}
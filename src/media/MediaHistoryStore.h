@@ -0,0 +1,96 @@
+/**
+ * @file MediaHistoryStore.h
+ * @brief Deduplicated storage for the media of each step of a track's history
+ */
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_cryptography/juce_cryptography.h>
+#include <juce_events/juce_events.h>
+
+#include "../TaskScheduler.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+using namespace juce;
+
+/*
+  Every processing run adds a step to the history of the output tracks, so
+  keeping a full copy of the media of each step would grow with the number
+  of runs. Instead, steps refer to entries of this store, which are keyed by
+  the hash of their content, so identical results share a single entry.
+
+  Files are added through a reflink (copy-on-write clone) where the file
+  system supports it, or else a hard link, falling back to a copy. Entries of
+  steps not currently shown are cold, and integer PCM WAV files are then
+  compressed to FLAC in the background. Showing a cold step again restores
+  the WAV file before it is loaded.
+
+  Entries are deleted once no step refers to them anymore. The store lives in
+  the session workspace, so anything left over is cleared with it. Meant to
+  be held through a SharedResourcePointer.
+*/
+class MediaHistoryStore
+{
+public:
+    class Entry
+    {
+    public:
+        ~Entry();
+
+        // Content in its original format, which only exists while the entry is active
+        File getFile() const { return file; }
+
+    private:
+        friend class MediaHistoryStore;
+
+        File file;
+        File compressedFile;
+
+        // Metadata of the WAV file, which FLAC does not keep
+        StringPairArray metadata;
+
+        std::mutex lock;
+        bool isCompressed = false;
+
+        // Number of tracks currently showing this entry
+        int numActive = 0;
+    };
+
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    MediaHistoryStore();
+
+    // Add a file to the store on the calling thread, or return the entry with the same content
+    EntryPtr add(const File& sourceFile);
+
+    // Add a file in the background lane, calling back on the message thread (nullptr on failure)
+    void addAsync(const File& sourceFile, std::function<void(EntryPtr)> onAdded);
+
+    /*
+      Mark an entry as shown by a track. The callback is invoked on the message
+      thread with the entry's file once it is available (restoring it first if
+      it was compressed), or with File() on failure.
+    */
+    void activateAsync(EntryPtr entry, std::function<void(const File&)> onActivated);
+
+    // Mark an entry as no longer shown by a track, compressing it once nothing shows it
+    void deactivate(EntryPtr entry);
+
+private:
+    static bool cloneOrLink(const File& sourceFile, const File& targetFile);
+
+    static void compress(EntryPtr entry);
+    static bool restore(Entry& entry);
+
+    File storeDirectory;
+
+    // By content hash and extension
+    std::map<String, std::weak_ptr<Entry>> entries;
+    std::mutex entriesLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MediaHistoryStore)
+};
@@ -0,0 +1,103 @@
+/**
+ * @file MediaLoader.h
+ * @brief Background loading of media files into displays
+ */
+
+#pragma once
+
+#include "juce_core/juce_core.h"
+#include "juce_gui_basics/juce_gui_basics.h"
+
+#include <atomic>
+
+using namespace juce;
+
+// Media decoded off the message thread, ready to be swapped into a display
+struct PreparedMedia
+{
+    virtual ~PreparedMedia() = default;
+};
+
+// Shared between a display and the background job loading media into it
+struct MediaLoadState
+{
+    std::atomic<bool> cancelled { false };
+
+    // Fraction of loading completed, or negative if unknown
+    std::atomic<float> progress { -1.0f };
+
+    bool shouldCancel() const { return cancelled.load(); }
+};
+
+/*
+  Runs on a worker thread. Must only use what it captured by value, since the
+  display it was created for may be destroyed while it is running. Returns
+  nullptr if loading failed or was cancelled.
+*/
+using MediaPreparer = std::function<std::unique_ptr<PreparedMedia>(MediaLoadState&)>;
+
+// Covers a display's media area while a file is loading
+class MediaLoadingOverlay : public Component, private Timer
+{
+public:
+    MediaLoadingOverlay() { setInterceptsMouseClicks(false, false); }
+
+    void startLoading(std::shared_ptr<MediaLoadState> state)
+    {
+        loadState = std::move(state);
+
+        setVisible(true);
+        toFront(false);
+        startTimerHz(20);
+    }
+
+    void stopLoading()
+    {
+        loadState.reset();
+
+        stopTimer();
+        setVisible(false);
+    }
+
+    void paint(Graphics& g) override
+    {
+        g.fillAll(Colours::black.withAlpha(0.4f));
+
+        Rectangle<float> area = getLocalBounds().toFloat().withSizeKeepingCentre(
+            jmin(200.0f, static_cast<float>(getWidth()) * 0.6f), 34.0f);
+
+        g.setColour(Colours::white);
+        g.setFont(14.0f);
+        g.drawFittedText(
+            "Loading...", area.removeFromTop(20.0f).toNearestInt(), Justification::centred, 1);
+
+        float progress = loadState != nullptr ? loadState->progress.load() : -1.0f;
+
+        Rectangle<float> bar = area.reduced(0.0f, 4.0f);
+
+        g.setColour(Colours::white.withAlpha(0.3f));
+        g.fillRoundedRectangle(bar, 2.0f);
+
+        g.setColour(Colours::lightblue);
+
+        if (progress >= 0.0f)
+        {
+            g.fillRoundedRectangle(bar.withWidth(bar.getWidth() * jmin(1.0f, progress)), 2.0f);
+        }
+        else
+        {
+            // Unknown progress, so sweep a short segment back and forth
+            float phase = static_cast<float>(Time::getMillisecondCounter() % 2000) / 1000.0f;
+            float position = phase < 1.0f ? phase : 2.0f - phase;
+            float width = bar.getWidth() * 0.25f;
+
+            g.fillRoundedRectangle(
+                bar.withWidth(width).withX(bar.getX() + position * (bar.getWidth() - width)), 2.0f);
+        }
+    }
+
+private:
+    void timerCallback() override { repaint(); }
+
+    std::shared_ptr<MediaLoadState> loadState;
+};
@@ -0,0 +1,368 @@
+#include "MidiBounce.h"
+
+#include "SegmentRenderQueue.h"
+
+#include "../TraceRecorder.h"
+#include "../pianoroll/SynthAudioSource.h"
+
+#include <array>
+#include <deque>
+#include <limits>
+
+String MidiBounce::getCacheVariant()
+{
+    return "bounce-" + String(SynthAudioSource::voiceBudget) + "voices";
+}
+
+bool MidiBounce::isMidiFile(const File& file)
+{
+    return file.hasFileExtension(".mid;.midi");
+}
+
+bool MidiBounce::renderToFile(const File& midiFile,
+                              const File& targetFile,
+                              MediaLoadState& loadState)
+{
+    HARP_TRACE_SCOPE("media", "MidiBounce::renderToFile");
+
+    auto sequence = std::make_shared<MidiMessageSequence>();
+
+    if (! readSequence(midiFile, *sequence))
+    {
+        return false;
+    }
+
+    double lengthInSecs = sequence->getEndTime() + tailLengthInSecs;
+    int64 totalNumSamples = static_cast<int64>(std::ceil(lengthInSecs * sampleRate));
+
+    auto segments = std::make_shared<const std::vector<Segment>>(
+        createSegments(*sequence, totalNumSamples));
+
+    auto outputStream = targetFile.createOutputStream();
+
+    if (outputStream == nullptr)
+    {
+        DBG("MidiBounce::renderToFile: Failed to create file " << targetFile.getFullPathName()
+                                                                << ".");
+        return false;
+    }
+
+    WavAudioFormat wavFormat;
+
+    std::unique_ptr<AudioFormatWriter> writer(wavFormat.createWriterFor(
+        outputStream.get(), sampleRate, numChannels, bitsPerSample, {}, 0));
+
+    if (writer == nullptr)
+    {
+        DBG("MidiBounce::renderToFile: Failed to create writer for "
+            << targetFile.getFullPathName() << ".");
+        return false;
+    }
+
+    // Writer now owns the stream
+    outputStream.release();
+
+    double startTime = Time::getMillisecondCounterHiRes();
+
+    std::vector<int> segmentLengths;
+
+    for (const auto& segment : *segments)
+    {
+        segmentLengths.push_back(static_cast<int>(segment.endSample - segment.startSample));
+    }
+
+    // Nobody is waiting on a bounce the way they wait on a decode
+    SegmentRenderQueue renderQueue(
+        TaskScheduler::Lane::Background,
+        segmentLengths,
+        numChannels,
+        [sequence, segments](size_t segmentIdx, AudioBuffer<float>& output)
+        { renderSegment(*sequence, (*segments)[segmentIdx], output); },
+        static_cast<size_t>(2 * SystemStats::getNumCpus()));
+
+    bool succeeded = true;
+
+    for (size_t segmentIdx = 0; segmentIdx < renderQueue.getNumSegments(); ++segmentIdx)
+    {
+        if (loadState.shouldCancel())
+        {
+            succeeded = false;
+            break;
+        }
+
+        std::unique_ptr<AudioBuffer<float>> output = renderQueue.getNextSegment();
+
+        if (! writer->writeFromAudioSampleBuffer(*output, 0, output->getNumSamples()))
+        {
+            succeeded = false;
+            break;
+        }
+
+        loadState.progress =
+            static_cast<float>(segmentIdx + 1) / static_cast<float>(renderQueue.getNumSegments());
+    }
+
+    if (succeeded)
+    {
+        double elapsedSecs = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        DBG("MidiBounce::renderToFile: Rendered " << lengthInSecs << " seconds of audio in "
+                                                  << elapsedSecs << " seconds ("
+                                                  << lengthInSecs / jmax(1.0e-6, elapsedSecs)
+                                                  << "x realtime).");
+    }
+
+    return succeeded;
+}
+
+bool MidiBounce::readSequence(const File& midiFile, MidiMessageSequence& sequence)
+{
+    std::unique_ptr<FileInputStream> fileStream(midiFile.createInputStream());
+
+    MidiFile file;
+
+    if (fileStream == nullptr || ! file.readFrom(*fileStream))
+    {
+        DBG("MidiBounce::readSequence: Error reading MIDI from file "
+            << midiFile.getFullPathName() << ".");
+        return false;
+    }
+
+    file.convertTimestampTicksToSeconds();
+
+    for (int trackIdx = 0; trackIdx < file.getNumTracks(); ++trackIdx)
+    {
+        if (const MidiMessageSequence* track = file.getTrack(trackIdx))
+        {
+            sequence.addSequence(*track, 0.0);
+        }
+    }
+
+    return true;
+}
+
+std::vector<MidiBounce::Segment> MidiBounce::createSegments(const MidiMessageSequence& sequence,
+                                                            int64 totalNumSamples)
+{
+    const int64 segmentLength = static_cast<int64>(segmentLengthInSecs * sampleRate);
+
+    std::vector<Segment> segments;
+
+    for (int64 startSample = 0; startSample < totalNumSamples; startSample += segmentLength)
+    {
+        Segment segment;
+        segment.startSample = startSample;
+        segment.endSample = jmin(startSample + segmentLength, totalNumSamples);
+        segment.prerollSample = startSample;
+
+        segments.push_back(segment);
+    }
+
+    auto toSamples = [](double timeInSecs) { return static_cast<int64>(timeInSecs * sampleRate); };
+
+    const int64 maxPrerollLength = toSamples(maxPrerollLengthInSecs);
+
+    /*
+      Move the preroll of every segment a note is still sounding at back to the
+      note's start, unless that is more than the maximum preroll away. Such a
+      note is resumed instead, and the preroll only covers its release.
+    */
+    auto addNote = [&](const HeldNote& note, int64 releaseSample)
+    {
+        int64 noteEndSample = releaseSample + toSamples(tailLengthInSecs);
+
+        for (size_t k = static_cast<size_t>(note.startSample / segmentLength) + 1;
+             k < segments.size() && segments[k].startSample <= noteEndSample;
+             ++k)
+        {
+            Segment& segment = segments[k];
+
+            if (note.startSample >= segment.startSample - maxPrerollLength)
+            {
+                segment.prerollSample = jmin(segment.prerollSample, note.startSample);
+            }
+            else
+            {
+                segment.prerollSample = jmin(segment.prerollSample, releaseSample);
+                segment.heldNotes.push_back(note);
+            }
+        }
+    };
+
+    // Notes waiting for a note off, by channel and note number (oldest first)
+    std::vector<std::deque<HeldNote>> openNotes(16 * 128);
+
+    // Notes released while the sustain pedal of their channel was down
+    std::array<std::vector<HeldNote>, 16> sustainedNotes;
+    std::array<bool, 16> isSustainOn {};
+
+    for (int eventIdx = 0; eventIdx < sequence.getNumEvents(); ++eventIdx)
+    {
+        const auto& midiMessage = sequence.getEventPointer(eventIdx)->message;
+
+        int64 eventSample = toSamples(midiMessage.getTimeStamp());
+        size_t channelIdx = static_cast<size_t>(midiMessage.getChannel() - 1);
+
+        if (midiMessage.isNoteOn())
+        {
+            HeldNote note;
+            note.channel = midiMessage.getChannel();
+            note.noteNumber = midiMessage.getNoteNumber();
+            note.velocity = midiMessage.getFloatVelocity();
+            note.startSample = eventSample;
+            note.noteOffSample = std::numeric_limits<int64>::max();
+
+            openNotes[channelIdx * 128 + static_cast<size_t>(note.noteNumber)].push_back(note);
+        }
+        else if (midiMessage.isNoteOff())
+        {
+            auto& keyNotes =
+                openNotes[channelIdx * 128 + static_cast<size_t>(midiMessage.getNoteNumber())];
+
+            if (! keyNotes.empty())
+            {
+                HeldNote note = keyNotes.front();
+                note.noteOffSample = eventSample;
+
+                if (isSustainOn[channelIdx])
+                {
+                    sustainedNotes[channelIdx].push_back(note);
+                }
+                else
+                {
+                    addNote(note, eventSample);
+                }
+
+                keyNotes.pop_front();
+            }
+        }
+        else if (midiMessage.isSustainPedalOn())
+        {
+            isSustainOn[channelIdx] = true;
+        }
+        else if (midiMessage.isSustainPedalOff())
+        {
+            isSustainOn[channelIdx] = false;
+
+            for (const HeldNote& note : sustainedNotes[channelIdx])
+            {
+                addNote(note, eventSample);
+            }
+
+            sustainedNotes[channelIdx].clear();
+        }
+    }
+
+    // Notes which are never released sound until the end
+    for (const auto& keyNotes : openNotes)
+    {
+        for (const HeldNote& note : keyNotes)
+        {
+            addNote(note, totalNumSamples);
+        }
+    }
+
+    for (const auto& channelNotes : sustainedNotes)
+    {
+        for (const HeldNote& note : channelNotes)
+        {
+            addNote(note, totalNumSamples);
+        }
+    }
+
+    return segments;
+}
+
+void MidiBounce::renderSegment(const MidiMessageSequence& sequence,
+                               const Segment& segment,
+                               AudioBuffer<float>& output)
+{
+    HARP_TRACE_SCOPE("media", "MidiBounce::renderSegment");
+
+    double prerollTime = static_cast<double>(segment.prerollSample) / sampleRate;
+    double endTime = static_cast<double>(segment.endSample) / sampleRate;
+
+    int firstIdx = sequence.getNextIndexAtTime(prerollTime);
+
+    // Sustain pedal state carries over from before the preroll
+    std::array<bool, 16> isSustainOn {};
+
+    for (int eventIdx = 0; eventIdx < firstIdx; ++eventIdx)
+    {
+        const auto& midiMessage = sequence.getEventPointer(eventIdx)->message;
+
+        if (midiMessage.isSustainPedalOn() || midiMessage.isSustainPedalOff())
+        {
+            isSustainOn[static_cast<size_t>(midiMessage.getChannel() - 1)] =
+                midiMessage.isSustainPedalOn();
+        }
+    }
+
+    MidiMessageSequence segmentSequence;
+
+    for (int eventIdx = firstIdx; eventIdx < sequence.getNumEvents(); ++eventIdx)
+    {
+        const auto& midiMessage = sequence.getEventPointer(eventIdx)->message;
+
+        if (midiMessage.getTimeStamp() >= endTime)
+        {
+            break;
+        }
+
+        segmentSequence.addEvent(midiMessage);
+    }
+
+    SynthAudioSource synth;
+
+    synth.prepareToPlay(renderBlockSize, sampleRate);
+    synth.useSequence(segmentSequence);
+    synth.setNextReadPosition(segment.prerollSample);
+
+    for (int channel = 1; channel <= 16; ++channel)
+    {
+        if (isSustainOn[static_cast<size_t>(channel - 1)])
+        {
+            synth.setSustainPedal(channel, true);
+        }
+    }
+
+    // After the pedal, so notes already released are left to it
+    for (const HeldNote& note : segment.heldNotes)
+    {
+        synth.resumeNote(note.channel,
+                         note.noteNumber,
+                         note.velocity,
+                         segment.prerollSample - note.startSample,
+                         note.noteOffSample >= segment.prerollSample);
+    }
+
+    AudioBuffer<float> block(numChannels, renderBlockSize);
+
+    for (int64 blockStart = segment.prerollSample; blockStart < segment.endSample;
+         blockStart += renderBlockSize)
+    {
+        int numSamples = static_cast<int>(jmin<int64>(renderBlockSize, segment.endSample - blockStart));
+
+        AudioSourceChannelInfo info(&block, 0, numSamples);
+        synth.getNextAudioBlock(info);
+
+        // Only keep what falls within the segment itself
+        int64 copyStart = jmax(blockStart, segment.startSample);
+        int numToCopy = static_cast<int>(blockStart + numSamples - copyStart);
+
+        if (numToCopy <= 0)
+        {
+            continue;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            output.copyFrom(ch,
+                            static_cast<int>(copyStart - segment.startSample),
+                            block,
+                            ch,
+                            static_cast<int>(copyStart - blockStart),
+                            numToCopy);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * @file MidiBounce.h
+ * @brief Offline rendering of MIDI files to audio, faster than realtime
+ */
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "MediaLoader.h"
+
+using namespace juce;
+
+/*
+  Renders a MIDI file with the same synth used for MIDI preview playback. The
+  timeline is split into fixed-length segments, each rendered with its own
+  synth on the background lane (see SegmentRenderQueue). A segment starts
+  rendering early enough to catch the notes still sounding at its start, up
+  to a second early. Notes held for longer are resumed where the preroll
+  starts, with the phase a continuous render would have reached, so notes
+  crossing a boundary sound the same either way. Finished
+  segments are written out in order as they come in, which keeps memory use
+  independent of the length of the file.
+*/
+class MidiBounce
+{
+public:
+    /*
+      Name under which bounces are stored in the DecodedAudioCache. It holds
+      the voice budget of the synth, which changes how dense passages sound.
+    */
+    static String getCacheVariant();
+
+    static bool isMidiFile(const File& file);
+
+    // Bounce a MIDI file to a WAV file (matches DecodedAudioCache::Renderer)
+    static bool renderToFile(const File& midiFile, const File& targetFile, MediaLoadState& loadState);
+
+private:
+    // Note which started too long before a segment to be played in its preroll
+    struct HeldNote
+    {
+        int channel = 1;
+        int noteNumber = 0;
+        float velocity = 0.0f;
+
+        int64 startSample = 0;
+
+        // Key release, after which the sustain pedal may still hold the note
+        int64 noteOffSample = 0;
+    };
+
+    struct Segment
+    {
+        int64 startSample = 0;
+        int64 endSample = 0;
+
+        // Where rendering starts, so notes held over from earlier segments are played
+        int64 prerollSample = 0;
+
+        // Resumed at the preroll, rather than replayed from their start
+        std::vector<HeldNote> heldNotes;
+    };
+
+    static bool readSequence(const File& midiFile, MidiMessageSequence& sequence);
+
+    static std::vector<Segment> createSegments(const MidiMessageSequence& sequence,
+                                               int64 totalNumSamples);
+
+    static void renderSegment(const MidiMessageSequence& sequence,
+                              const Segment& segment,
+                              AudioBuffer<float>& output);
+
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int numChannels = 1;
+    static constexpr int bitsPerSample = 24;
+
+    static constexpr double segmentLengthInSecs = 10.0;
+
+    // Covers the release of the preview synth's voices
+    static constexpr double tailLengthInSecs = 0.05;
+
+    // Longer than the tail, so a note released just before a segment is always in its preroll
+    static constexpr double maxPrerollLengthInSecs = 1.0;
+
+    static constexpr int renderBlockSize = 512;
+};
@@ -1,5 +1,8 @@
 #include "MidiDisplayComponent.h"
 
+#include <array>
+#include <deque>
+
 MidiDisplayComponent::MidiDisplayComponent() : MediaDisplayComponent("Midi Track") {}
 
 MidiDisplayComponent::MidiDisplayComponent(String name, bool req, bool fromDAW, DisplayMode mode)
@@ -40,110 +43,170 @@ void MidiDisplayComponent::resized()
     pianoRoll.setBounds(contentComponent.getBounds().withY(0));
 }
 
-void MidiDisplayComponent::loadMediaFile(const URL& filePath)
+MediaPreparer MidiDisplayComponent::createMediaPreparer(const URL& filePath)
 {
-    File file = filePath.getLocalFile();
+    return [filePath](MediaLoadState& loadState) -> std::unique_ptr<PreparedMedia>
+    {
+        File file = filePath.getLocalFile();
 
-    std::unique_ptr<FileInputStream> fileStream(file.createInputStream());
+        std::unique_ptr<FileInputStream> fileStream(file.createInputStream());
 
-    MidiFile midiFile;
+        if (fileStream == nullptr)
+        {
+            DBG("MidiDisplayComponent::createMediaPreparer: Failed to open file "
+                << file.getFullPathName() << ".");
+            return nullptr;
+        }
 
-    if (! midiFile.readFrom(*fileStream))
-    {
-        DBG("MidiDisplayComponent::loadMediaFile: Error reading MIDI from file "
-            << file.getFullPathName() << ".");
-        // TODO - better error handing
-        //jassertfalse;
-        //return;
-    }
+        MidiFile midiFile;
 
-    midiFile.convertTimestampTicksToSeconds();
+        if (! midiFile.readFrom(*fileStream))
+        {
+            DBG("MidiDisplayComponent::createMediaPreparer: Error reading MIDI from file "
+                << file.getFullPathName() << ".");
+            // TODO - better error handing
+            //jassertfalse;
+            //return nullptr;
+        }
 
-    totalLengthInSecs = midiFile.getLastTimestamp();
+        midiFile.convertTimestampTicksToSeconds();
 
-    //DBG("MidiDisplayComponent::loadMediaFile: Total duration of MIDI file " << totalLengthInSecs << " seconds.");
+        auto media = std::make_unique<PreparedMidi>();
 
-    pianoRoll.resizeNoteGrid(totalLengthInSecs);
+        media->totalLengthInSecs = midiFile.getLastTimestamp();
 
-    MidiMessageSequence allTracks;
+        //DBG("MidiDisplayComponent::createMediaPreparer: Total duration of MIDI file " << media->totalLengthInSecs << " seconds.");
 
-    for (int trackIdx = 0; trackIdx < midiFile.getNumTracks(); ++trackIdx)
-    {
-        const MidiMessageSequence* constTrack = midiFile.getTrack(trackIdx);
+        MidiMessageSequence& allTracks = media->allTracks;
 
-        if (constTrack != nullptr)
+        for (int trackIdx = 0; trackIdx < midiFile.getNumTracks(); ++trackIdx)
         {
-            allTracks.addSequence(*constTrack, 0.0);
-            allTracks.updateMatchedPairs();
+            const MidiMessageSequence* constTrack = midiFile.getTrack(trackIdx);
+
+            if (constTrack != nullptr)
+            {
+                allTracks.addSequence(*constTrack, 0.0);
+            }
         }
-    }
 
-    // Keep track of note MIDI numbers
-    std::vector<int> midiNumbers;
+        const int numEvents = allTracks.getNumEvents();
 
-    for (int eventIdx = 0; eventIdx < allTracks.getNumEvents(); ++eventIdx)
-    {
-        const auto midiEvent = allTracks.getEventPointer(eventIdx);
-        const auto& midiMessage = midiEvent->message;
+        media->notes.reserve(static_cast<size_t>(numEvents / 2));
+
+        /*
+          Notes still waiting for their note off event, for each channel and
+          note number. Note offs close the oldest open note of their key, so
+          overlapping notes of the same pitch pair up in order.
+        */
+        std::vector<std::deque<size_t>> openNotes(16 * 128);
 
-        double startTime = midiEvent->message.getTimeStamp();
+        // Occurrences of each MIDI number, for the median
+        std::array<int, 128> noteCounts {};
 
-        //DBG("MidiDisplayComponent::loadMediaFile: Event " << eventIdx << " at " << startTime << ": " << midiMessage.getDescription());
+        double sum = 0.0;
+        double sqSum = 0.0;
 
-        if (midiMessage.isNoteOn())
+        for (int eventIdx = 0; eventIdx < numEvents; ++eventIdx)
         {
-            int noteChannel = midiMessage.getChannel();
-            int noteNumber = midiMessage.getNoteNumber();
-            int velocity = midiMessage.getVelocity();
+            if (eventIdx % progressInterval == 0)
+            {
+                if (loadState.shouldCancel())
+                {
+                    return nullptr;
+                }
+
+                loadState.progress = static_cast<float>(eventIdx) / static_cast<float>(numEvents);
+            }
+
+            const auto& midiMessage = allTracks.getEventPointer(eventIdx)->message;
+
+            //DBG("MidiDisplayComponent::createMediaPreparer: Event " << eventIdx << " at " << midiMessage.getTimeStamp() << ": " << midiMessage.getDescription());
+
+            if (midiMessage.isNoteOn())
+            {
+                int noteNumber = midiMessage.getNoteNumber();
+                size_t key = static_cast<size_t>((midiMessage.getChannel() - 1) * 128 + noteNumber);
 
-            midiNumbers.push_back(noteNumber);
+                openNotes[key].push_back(media->notes.size());
 
-            double duration = 0;
+                // Duration is filled in once the matching note off is found
+                media->notes.push_back(MidiNote(static_cast<unsigned char>(noteNumber),
+                                                midiMessage.getTimeStamp(),
+                                                0.0,
+                                                midiMessage.getVelocity()));
 
-            for (int offIdx = eventIdx + 1; offIdx < allTracks.getNumEvents(); ++offIdx)
+                ++noteCounts[static_cast<size_t>(noteNumber)];
+
+                sum += noteNumber;
+                sqSum += noteNumber * noteNumber;
+            }
+            else if (midiMessage.isNoteOff())
             {
-                const auto offEvent = allTracks.getEventPointer(offIdx);
+                size_t key = static_cast<size_t>((midiMessage.getChannel() - 1) * 128
+                                                 + midiMessage.getNoteNumber());
 
-                // Find matching note offset event
-                if (offEvent->message.isNoteOff() && offEvent->message.getNoteNumber() == noteNumber
-                    && offEvent->message.getChannel() == noteChannel)
+                if (! openNotes[key].empty())
                 {
-                    duration =
-                        (offEvent->message.getTimeStamp() - midiEvent->message.getTimeStamp());
-                    break;
+                    MidiNote& n = media->notes[openNotes[key].front()];
+                    n.duration = midiMessage.getTimeStamp() - n.startTime;
+
+                    openNotes[key].pop_front();
                 }
             }
+        }
 
-            // Create component for each for each note and add to pianoroll
-            MidiNote n = MidiNote(static_cast<unsigned char>(noteNumber),
-                                  startTime,
-                                  duration,
-                                  static_cast<unsigned char>(velocity));
-            pianoRoll.insertNote(n);
+        int numNotes = static_cast<int>(media->notes.size());
+
+        if (numNotes == 0)
+        {
+            return media;
         }
-    }
 
-    // Compute median and standard deviation of MIDI numbers
-    std::sort(midiNumbers.begin(), midiNumbers.end());
+        // Median of MIDI numbers from their counts (mean of the middle two for an even count)
+        auto findNthNumber = [&noteCounts](int n)
+        {
+            int noteNumber = 0;
+
+            for (int seen = noteCounts[0]; seen <= n;
+                 seen += noteCounts[static_cast<size_t>(noteNumber)])
+            {
+                ++noteNumber;
+            }
 
-    int numNotes = midiNumbers.size();
+            return noteNumber;
+        };
 
-    medianMidi = midiNumbers[numNotes / 2];
+        media->medianMidi = findNthNumber(numNotes / 2);
 
-    if (! numNotes % 2)
-    {
-        medianMidi += midiNumbers[numNotes / 2 - 1];
-        medianMidi /= 2;
-    }
+        if (numNotes % 2 == 0)
+        {
+            media->medianMidi = (media->medianMidi + findNthNumber(numNotes / 2 - 1)) / 2;
+        }
+
+        double mean = sum / numNotes;
+
+        media->stdDevMidi = static_cast<float>(std::sqrt(jmax(0.0, sqSum / numNotes - mean * mean)));
+
+        loadState.progress = 1.0f;
+
+        return media;
+    };
+}
+
+void MidiDisplayComponent::loadMediaFile(const URL& /*filePath*/, PreparedMedia& media)
+{
+    auto& midi = static_cast<PreparedMidi&>(media);
+
+    totalLengthInSecs = midi.totalLengthInSecs;
+
+    pianoRoll.resizeNoteGrid(totalLengthInSecs);
 
-    float sum = std::accumulate(midiNumbers.begin(), midiNumbers.end(), 0.0f);
-    float mean = sum / static_cast<float>(numNotes);
-    float sq_sum =
-        std::inner_product(midiNumbers.begin(), midiNumbers.end(), midiNumbers.begin(), 0.0f);
+    pianoRoll.insertNotes(midi.notes);
 
-    stdDevMidi = std::sqrt(sq_sum / static_cast<float>(numNotes) - mean * mean);
+    medianMidi = midi.medianMidi;
+    stdDevMidi = midi.stdDevMidi;
 
-    synthAudioSource.useSequence(allTracks);
+    synthAudioSource.useSequence(midi.allTracks);
     transportSource.setSource(&synthAudioSource);
 }
 
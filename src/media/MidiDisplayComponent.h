@@ -22,17 +22,32 @@ public:
 
     void resized() override;
 
-    void loadMediaFile(const URL& filePath) override;
-
     double getTotalLengthInSecs() override { return totalLengthInSecs; }
     float getPixelsPerSecond() override { return static_cast<float>(pianoRoll.getResolution()); }
 
 private:
+    struct PreparedMidi : public PreparedMedia
+    {
+        MidiMessageSequence allTracks;
+        std::vector<MidiNote> notes;
+
+        double totalLengthInSecs = 0.0;
+
+        // Default to a vertically centred view when there are no notes
+        int medianMidi = 64;
+        float stdDevMidi = 0.0f;
+    };
+
+    // Number of events processed between checks for cancellation
+    static constexpr int progressInterval = 512;
+
     void visibleRangeCallback() override {}
     void changeListenerCallback(ChangeBroadcaster*) override { repositionLabels(); }
 
     void resetMedia() override;
 
+    MediaPreparer createMediaPreparer(const URL& filePath) override;
+    void loadMediaFile(const URL& filePath, PreparedMedia& media) override;
     void postLoadActions(const URL& filePath) override;
 
     Component* getMediaComponent() override { return pianoRoll.getNoteGrid(); }
@@ -57,8 +72,8 @@ private:
         return dynamic_cast<MidiLabel*>(l.get()) != nullptr;
     }
 
-    int medianMidi;
-    float stdDevMidi;
+    int medianMidi = 64;
+    float stdDevMidi = 0.0f;
 
     double totalLengthInSecs = 0.0;
 
@@ -0,0 +1,131 @@
+#include "SegmentRenderQueue.h"
+
+#include <map>
+
+struct SegmentRenderQueue::State
+{
+    State(std::vector<int> lengths, int channels, Renderer r)
+        : segmentLengths(std::move(lengths)),
+          numChannels(channels),
+          renderer(std::move(r)),
+          claimed(std::make_unique<std::atomic<bool>[]>(segmentLengths.size()))
+    {
+        for (size_t i = 0; i < segmentLengths.size(); ++i)
+        {
+            claimed[i].store(false);
+        }
+    }
+
+    // Only the first thread to claim a segment renders it
+    bool claim(size_t segmentIdx) { return ! claimed[segmentIdx].exchange(true); }
+
+    std::unique_ptr<AudioBuffer<float>> render(size_t segmentIdx)
+    {
+        auto output = std::make_unique<AudioBuffer<float>>(numChannels, segmentLengths[segmentIdx]);
+        output->clear();
+
+        renderer(segmentIdx, *output);
+
+        return output;
+    }
+
+    const std::vector<int> segmentLengths;
+    const int numChannels;
+    const Renderer renderer;
+
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+
+    std::atomic<bool> cancelled { false };
+
+    // Segments rendered by workers, waiting to be consumed, by index
+    std::map<size_t, std::unique_ptr<AudioBuffer<float>>> renderedSegments;
+    CriticalSection renderedSegmentsLock;
+    WaitableEvent segmentRendered;
+};
+
+SegmentRenderQueue::SegmentRenderQueue(TaskScheduler::Lane l,
+                                       std::vector<int> segmentLengths,
+                                       int numChannels,
+                                       Renderer renderer,
+                                       size_t maxAhead)
+    : lane(l), numSegments(segmentLengths.size()), maxNumRenderedAhead(maxAhead)
+{
+    state = std::make_shared<State>(std::move(segmentLengths), numChannels, std::move(renderer));
+}
+
+SegmentRenderQueue::~SegmentRenderQueue()
+{
+    state->cancelled = true;
+
+    for (auto& task : renderTasks)
+    {
+        task->cancel();
+    }
+}
+
+std::unique_ptr<AudioBuffer<float>> SegmentRenderQueue::getNextSegment()
+{
+    if (nextIdx >= numSegments)
+    {
+        return nullptr;
+    }
+
+    size_t segmentIdx = nextIdx++;
+
+    submitRenders();
+
+    // No worker has started it, so render it here rather than wait
+    if (state->claim(segmentIdx))
+    {
+        return state->render(segmentIdx);
+    }
+
+    while (true)
+    {
+        {
+            const ScopedLock sl(state->renderedSegmentsLock);
+
+            if (auto it = state->renderedSegments.find(segmentIdx);
+                it != state->renderedSegments.end())
+            {
+                auto output = std::move(it->second);
+                state->renderedSegments.erase(it);
+
+                return output;
+            }
+        }
+
+        state->segmentRendered.wait(100);
+    }
+}
+
+void SegmentRenderQueue::submitRenders()
+{
+    // The segment about to be consumed is not submitted ahead of time
+    numSubmitted = jmax(numSubmitted, nextIdx);
+
+    while (numSubmitted < numSegments && numSubmitted < nextIdx + maxNumRenderedAhead)
+    {
+        size_t segmentIdx = numSubmitted++;
+
+        renderTasks.push_back(scheduler->submit(
+            lane,
+            [s = state, segmentIdx]
+            {
+                if (s->cancelled.load() || ! s->claim(segmentIdx))
+                {
+                    return;
+                }
+
+                auto output = s->render(segmentIdx);
+
+                {
+                    const ScopedLock sl(s->renderedSegmentsLock);
+
+                    s->renderedSegments[segmentIdx] = std::move(output);
+                }
+
+                s->segmentRendered.signal();
+            }));
+    }
+}
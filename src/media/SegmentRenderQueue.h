@@ -0,0 +1,75 @@
+/**
+ * @file SegmentRenderQueue.h
+ * @brief Parallel rendering of fixed-length segments, handed back in order
+ */
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "../TaskScheduler.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace juce;
+
+/*
+  Used by MidiBounce and AudioTranscoder, which split their output into
+  segments that are rendered in parallel and written out in order. Renders
+  are submitted to a lane of the TaskScheduler, at most a fixed number ahead
+  of the segment being consumed, so memory use does not depend on the length
+  of the file.
+
+  The consumer usually runs on a worker of the scheduler itself. Rather than
+  block on a segment no worker has started yet, it renders that segment on
+  its own thread, so it never waits on work which may be queued behind it.
+  Renders only hold on to state shared with the queue, which can therefore
+  be destroyed without waiting for them.
+*/
+class SegmentRenderQueue
+{
+public:
+    /*
+      Renders a segment into a cleared buffer of its length. Called on any
+      thread, possibly after the queue is gone, so it must only use what it
+      captured by value (or through shared pointers). References are fine
+      when nothing is rendered ahead (maxNumRenderedAhead is 0).
+    */
+    using Renderer = std::function<void(size_t segmentIdx, AudioBuffer<float>& output)>;
+
+    SegmentRenderQueue(TaskScheduler::Lane lane,
+                       std::vector<int> segmentLengths,
+                       int numChannels,
+                       Renderer renderer,
+                       size_t maxNumRenderedAhead);
+
+    // Skips renders which have not started, without waiting for running ones
+    ~SegmentRenderQueue();
+
+    // Next segment in order, or nullptr once all of them have been returned
+    std::unique_ptr<AudioBuffer<float>> getNextSegment();
+
+    size_t getNumSegments() const { return numSegments; }
+
+private:
+    struct State;
+
+    void submitRenders();
+
+    std::shared_ptr<State> state;
+
+    const TaskScheduler::Lane lane;
+    const size_t numSegments;
+    const size_t maxNumRenderedAhead;
+
+    size_t nextIdx = 0;
+    size_t numSubmitted = 0;
+
+    std::vector<std::shared_ptr<TaskScheduler::TaskHandle>> renderTasks;
+
+    SharedResourcePointer<TaskScheduler> scheduler;
+
+    JUCE_DECLARE_NON_COPYABLE(SegmentRenderQueue)
+};
@@ -0,0 +1,446 @@
+#include "SpectrogramTileCache.h"
+
+namespace
+{
+const float minFrequency = 20.0f;
+const float maxFrequency = 20000.0f;
+} // namespace
+
+SpectrogramTileCache::SpectrogramTileCache(std::function<void()> onTilesReady)
+    : tilesReadyCallback(std::move(onTilesReady))
+{
+    fftData.calloc(2 * fftSize);
+
+    ColourGradient gradient(Colours::black, 0.0f, 0.0f, Colours::white, 1.0f, 0.0f, false);
+    gradient.addColour(0.3, Colours::darkblue);
+    gradient.addColour(0.55, Colours::purple);
+    gradient.addColour(0.8, Colours::orange);
+    gradient.addColour(0.95, Colours::yellow);
+
+    for (int i = 0; i < 256; ++i)
+    {
+        colourMap[i] = gradient.getColourAtPosition(i / 255.0);
+    }
+}
+
+SpectrogramTileCache::~SpectrogramTileCache()
+{
+    detachFromWorker();
+
+    cancelPendingUpdate();
+}
+
+void SpectrogramTileCache::setReader(std::unique_ptr<AudioFormatReader> newReader)
+{
+    bool hasNewReader = newReader != nullptr;
+
+    if (! hasNewReader)
+    {
+        detachFromWorker();
+    }
+
+    {
+        const ScopedLock sl(lock);
+
+        sampleRate = hasNewReader ? newReader->sampleRate : 0.0;
+        lengthInSamples = hasNewReader ? newReader->lengthInSamples : 0;
+
+        // Handed over to the worker thread on its next time slice
+        incomingReader = std::move(newReader);
+        readerChanged = true;
+
+        tiles.clear();
+        pendingTiles.clear();
+        generation++;
+    }
+
+    if (hasNewReader && workerThread == nullptr)
+    {
+        workerThread = workerPool->acquireThread();
+        workerThread->addTimeSliceClient(this);
+    }
+}
+
+void SpectrogramTileCache::detachFromWorker()
+{
+    if (workerThread == nullptr)
+    {
+        return;
+    }
+
+    // Blocks until any tile currently being computed for this cache is finished
+    workerThread->removeTimeSliceClient(this);
+
+    workerPool->releaseThread(workerThread);
+    workerThread = nullptr;
+
+    // Worker no longer touches it
+    reader.reset();
+}
+
+bool SpectrogramTileCache::hasReader()
+{
+    const ScopedLock sl(lock);
+
+    return sampleRate > 0.0;
+}
+
+float SpectrogramTileCache::frequencyToRelativeY(float frequency)
+{
+    float f = jlimit(minFrequency, maxFrequency, frequency);
+
+    return 1.0f - std::log(f / minFrequency) / std::log(maxFrequency / minFrequency);
+}
+
+float SpectrogramTileCache::relativeYToFrequency(float relativeY)
+{
+    return minFrequency * std::pow(maxFrequency / minFrequency, 1.0f - relativeY);
+}
+
+void SpectrogramTileCache::draw(Graphics& g, Rectangle<int> bounds, Range<double> visibleRange)
+{
+    if (bounds.isEmpty() || visibleRange.getLength() <= 0.0)
+    {
+        return;
+    }
+
+    Rectangle<float> clipBounds = g.getClipBounds().toFloat();
+
+    bool needsCompute = false;
+
+    {
+        const ScopedLock sl(lock);
+
+        if (sampleRate <= 0.0)
+        {
+            return;
+        }
+
+        double totalLength = static_cast<double>(lengthInSamples) / sampleRate;
+        double pixelsPerSecond = static_cast<double>(bounds.getWidth()) / visibleRange.getLength();
+
+        int level = getLevelForZoom(sampleRate / pixelsPerSecond);
+        double tileDuration = getTileDuration(level);
+
+        int64 firstIndex = jmax(static_cast<int64>(0),
+                                static_cast<int64>(std::floor(visibleRange.getStart() / tileDuration)));
+        int64 lastIndex = static_cast<int64>(
+            std::floor(jmin(visibleRange.getEnd(), totalLength) / tileDuration));
+
+        useCounter++;
+
+        Array<TileKey> missingTiles;
+
+        for (int64 i = firstIndex; i <= lastIndex; ++i)
+        {
+            TileKey key { level, i };
+
+            Rectangle<float> area(
+                static_cast<float>(bounds.getX()
+                                   + (i * tileDuration - visibleRange.getStart()) * pixelsPerSecond),
+                static_cast<float>(bounds.getY()),
+                static_cast<float>(tileDuration * pixelsPerSecond),
+                static_cast<float>(bounds.getHeight()));
+
+            auto it = tiles.find(key);
+
+            if (it == tiles.end())
+            {
+                missingTiles.add(key);
+            }
+            else
+            {
+                it->second.lastUsed = useCounter;
+            }
+
+            if (! area.intersects(clipBounds))
+            {
+                continue;
+            }
+
+            if (it != tiles.end())
+            {
+                g.drawImage(it->second.image, area);
+            }
+            else
+            {
+                drawFallbackTiles(g, key, area, pixelsPerSecond);
+            }
+        }
+
+        // Compute visible tiles closest to the centre of the view first
+        int64 centreIndex = (firstIndex + lastIndex) / 2;
+
+        std::stable_sort(missingTiles.begin(),
+                         missingTiles.end(),
+                         [centreIndex](const TileKey& a, const TileKey& b)
+                         { return std::abs(a.index - centreIndex) < std::abs(b.index - centreIndex); });
+
+        // Then one tile on each side to hide short scrolls
+        for (int64 i : { firstIndex - 1, lastIndex + 1 })
+        {
+            if (i >= 0 && i * tileDuration < totalLength && tiles.find({ level, i }) == tiles.end())
+            {
+                missingTiles.add({ level, i });
+            }
+        }
+
+        // Anything requested for a previous view is no longer needed
+        pendingTiles.swapWith(missingTiles);
+
+        needsCompute = ! pendingTiles.isEmpty();
+    }
+
+    if (needsCompute && workerThread != nullptr)
+    {
+        workerThread->moveToFrontOfQueue(this);
+    }
+}
+
+int SpectrogramTileCache::useTimeSlice()
+{
+    TileKey key;
+    uint32 tileGeneration;
+
+    {
+        const ScopedLock sl(lock);
+
+        if (readerChanged)
+        {
+            reader = std::move(incomingReader);
+            readerChanged = false;
+
+            if (reader != nullptr)
+            {
+                updateRowBins(reader->sampleRate);
+            }
+        }
+
+        if (reader == nullptr || pendingTiles.isEmpty())
+        {
+            return idleIntervalMs;
+        }
+
+        key = pendingTiles.removeAndReturn(0);
+        tileGeneration = generation;
+    }
+
+    Image image = renderTile(key);
+
+    {
+        const ScopedLock sl(lock);
+
+        // Drop tiles computed for audio that has since been replaced
+        if (tileGeneration != generation)
+        {
+            return 0;
+        }
+
+        tiles[key] = { image, useCounter };
+
+        evictLeastRecentlyUsedTiles();
+    }
+
+    triggerAsyncUpdate();
+
+    return 0;
+}
+
+void SpectrogramTileCache::handleAsyncUpdate()
+{
+    if (tilesReadyCallback)
+    {
+        tilesReadyCallback();
+    }
+}
+
+Image SpectrogramTileCache::renderTile(const TileKey& key)
+{
+    Image image(Image::RGB, framesPerTile, numRows, true, SoftwareImageType());
+    Image::BitmapData pixels(image, Image::BitmapData::writeOnly);
+
+    int64 hopSize = static_cast<int64>(minHopSize) << key.level;
+    int numBins = fftSize / 2 + 1;
+
+    for (int column = 0; column < framesPerTile; ++column)
+    {
+        int64 frame = key.index * framesPerTile + column;
+        int64 centreSample = frame * hopSize + hopSize / 2;
+
+        if (centreSample >= reader->lengthInSamples)
+        {
+            break;
+        }
+
+        computeMagnitudes(centreSample);
+
+        for (int row = 0; row < numRows; ++row)
+        {
+            int start = rowBinStart.getUnchecked(row);
+
+            if (start >= numBins)
+            {
+                continue;
+            }
+
+            // Higher rows span several bins, so show the strongest one
+            float magnitude =
+                FloatVectorOperations::findMaximum(fftData.get() + start,
+                                                   rowBinEnd.getUnchecked(row) - start);
+            float decibels = Decibels::gainToDecibels(magnitude, minDecibels);
+
+            int colourIndex =
+                jlimit(0, 255, roundToInt(jmap(decibels, minDecibels, 0.0f, 0.0f, 255.0f)));
+
+            pixels.setPixelColour(column, row, colourMap[colourIndex]);
+        }
+    }
+
+    return image;
+}
+
+void SpectrogramTileCache::computeMagnitudes(int64 centreSample)
+{
+    float* data = fftData.get();
+
+    FloatVectorOperations::clear(data, 2 * fftSize);
+
+    int64 frameStart = centreSample - fftSize / 2;
+    int64 readStart = jmax(static_cast<int64>(0), frameStart);
+    int64 readEnd = jmin(reader->lengthInSamples, frameStart + fftSize);
+
+    if (readEnd > readStart)
+    {
+        int numSamples = static_cast<int>(readEnd - readStart);
+        int offset = static_cast<int>(readStart - frameStart);
+
+        reader->read(&readBuffer, 0, numSamples, readStart, true, reader->numChannels > 1);
+
+        // Mix down to mono
+        FloatVectorOperations::copy(data + offset, readBuffer.getReadPointer(0), numSamples);
+
+        if (reader->numChannels > 1)
+        {
+            FloatVectorOperations::add(data + offset, readBuffer.getReadPointer(1), numSamples);
+            FloatVectorOperations::multiply(data + offset, 0.5f, numSamples);
+        }
+    }
+
+    window.multiplyWithWindowingTable(data, static_cast<size_t>(fftSize));
+    fft.performFrequencyOnlyForwardTransform(data, true);
+
+    // Full-scale sinusoid maps to 0 dB
+    FloatVectorOperations::multiply(data, 2.0f / static_cast<float>(fftSize), fftSize / 2 + 1);
+}
+
+void SpectrogramTileCache::updateRowBins(double newSampleRate)
+{
+    rowBinStart.clearQuick();
+    rowBinEnd.clearQuick();
+
+    double binsPerHz = static_cast<double>(fftSize) / newSampleRate;
+
+    for (int row = 0; row < numRows; ++row)
+    {
+        // Row 0 is the top of the image (highest frequency)
+        double highFrequency = relativeYToFrequency(static_cast<float>(row) / numRows);
+        double lowFrequency = relativeYToFrequency(static_cast<float>(row + 1) / numRows);
+
+        int start = static_cast<int>(std::floor(lowFrequency * binsPerHz));
+        int end = jmax(start + 1, static_cast<int>(std::ceil(highFrequency * binsPerHz)));
+
+        // Rows above Nyquist start past the last bin and are left black
+        rowBinStart.add(start);
+        rowBinEnd.add(jmin(end, fftSize / 2 + 1));
+    }
+}
+
+int SpectrogramTileCache::getLevelForZoom(double samplesPerPixel) const
+{
+    int level = 0;
+
+    // Use the finest level with at most one frame per pixel
+    while (level < numLevels - 1 && static_cast<double>(minHopSize << level) < samplesPerPixel)
+    {
+        level++;
+    }
+
+    return level;
+}
+
+double SpectrogramTileCache::getTileDuration(int level) const
+{
+    return static_cast<double>(static_cast<int64>(framesPerTile) * (minHopSize << level))
+           / sampleRate;
+}
+
+void SpectrogramTileCache::drawFallbackTiles(Graphics& g,
+                                             const TileKey& missingKey,
+                                             Rectangle<float> area,
+                                             double pixelsPerSecond)
+{
+    double startTime = missingKey.index * getTileDuration(missingKey.level);
+    double endTime = startTime + getTileDuration(missingKey.level);
+
+    Graphics::ScopedSaveState state(g);
+    g.reduceClipRegion(area.getSmallestIntegerContainer());
+
+    // Prefer coarser levels, which cover the area with fewer tiles
+    for (int distance = 1; distance < numLevels; ++distance)
+    {
+        for (int level : { missingKey.level + distance, missingKey.level - distance })
+        {
+            if (level < 0 || level >= numLevels)
+            {
+                continue;
+            }
+
+            double tileDuration = getTileDuration(level);
+
+            int64 firstIndex = static_cast<int64>(std::floor(startTime / tileDuration));
+            int64 lastIndex = static_cast<int64>(std::ceil(endTime / tileDuration)) - 1;
+
+            bool drewAnything = false;
+
+            for (auto it = tiles.lower_bound({ level, firstIndex });
+                 it != tiles.end() && it->first.level == level && it->first.index <= lastIndex;
+                 ++it)
+            {
+                Rectangle<float> tileArea(
+                    static_cast<float>(area.getX()
+                                       + (it->first.index * tileDuration - startTime)
+                                             * pixelsPerSecond),
+                    area.getY(),
+                    static_cast<float>(tileDuration * pixelsPerSecond),
+                    area.getHeight());
+
+                g.drawImage(it->second.image, tileArea);
+
+                drewAnything = true;
+            }
+
+            if (drewAnything)
+            {
+                return;
+            }
+        }
+    }
+}
+
+void SpectrogramTileCache::evictLeastRecentlyUsedTiles()
+{
+    while (static_cast<int>(tiles.size()) > maxNumTiles)
+    {
+        auto oldest = tiles.begin();
+
+        for (auto it = tiles.begin(); it != tiles.end(); ++it)
+        {
+            if (it->second.lastUsed < oldest->second.lastUsed)
+            {
+                oldest = it;
+            }
+        }
+
+        tiles.erase(oldest);
+    }
+}
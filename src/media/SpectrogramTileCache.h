@@ -0,0 +1,139 @@
+/**
+ * @file SpectrogramTileCache.h
+ * @brief Spectrogram images computed on worker threads in tiles of STFT frames
+ */
+
+#pragma once
+
+#include <juce_audio_utils/juce_audio_utils.h>
+#include <juce_dsp/juce_dsp.h>
+#include <map>
+
+#include "TimeSliceThreadPool.h"
+
+using namespace juce;
+
+// Low-priority worker threads shared by all spectrogram tile caches
+class SpectrogramWorkerPool : public TimeSliceThreadPool
+{
+public:
+    SpectrogramWorkerPool() : TimeSliceThreadPool("Spectrogram Worker Thread", Thread::Priority::low)
+    {
+    }
+};
+
+/*
+  Each zoom level uses a hop size twice as large as the one before it, and a
+  tile holds a fixed number of STFT frames at one level. Tiles only depend on
+  the audio, not on the size of the display, so they are simply stretched when
+  drawn and survive resizing, scrolling and zooming within a level. Only the
+  frames in view are computed, visible tiles closest to the centre first, which
+  keeps the cost independent of the length of the file.
+
+  Rows use the same logarithmic frequency axis as spectrogram label overlays.
+*/
+class SpectrogramTileCache : private TimeSliceClient, private AsyncUpdater
+{
+public:
+    SpectrogramTileCache(std::function<void()> onTilesReady);
+    ~SpectrogramTileCache() override;
+
+    // Take ownership of a reader for the audio to analyze (nullptr to clear)
+    void setReader(std::unique_ptr<AudioFormatReader> newReader);
+
+    bool hasReader();
+
+    // Draw cached tiles for the visible range and queue any that are missing
+    void draw(Graphics& g, Rectangle<int> bounds, Range<double> visibleRange);
+
+    static float frequencyToRelativeY(float frequency);
+    static float relativeYToFrequency(float relativeY);
+
+private:
+    struct TileKey
+    {
+        int level;
+        int64 index;
+
+        bool operator<(const TileKey& other) const
+        {
+            return std::tie(level, index) < std::tie(other.level, other.index);
+        }
+
+        bool operator==(const TileKey& other) const
+        {
+            return level == other.level && index == other.index;
+        }
+    };
+
+    struct Tile
+    {
+        Image image;
+        uint32 lastUsed;
+    };
+
+    int useTimeSlice() override;
+    void handleAsyncUpdate() override;
+
+    // Called on the worker thread only
+    Image renderTile(const TileKey& key);
+    void computeMagnitudes(int64 centreSample);
+    void updateRowBins(double sampleRate);
+
+    int getLevelForZoom(double samplesPerPixel) const;
+    double getTileDuration(int level) const;
+
+    void drawFallbackTiles(Graphics& g,
+                           const TileKey& missingKey,
+                           Rectangle<float> area,
+                           double pixelsPerSecond);
+    void evictLeastRecentlyUsedTiles();
+
+    // Stop the worker from calling back, so it no longer polls a cache without audio
+    void detachFromWorker();
+
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int minHopSize = 128;
+    static constexpr int numLevels = 14;
+    static constexpr int framesPerTile = 128;
+    static constexpr int numRows = 256;
+    static constexpr int maxNumTiles = 96;
+    static constexpr int idleIntervalMs = 500;
+    static constexpr float minDecibels = -100.0f;
+
+    std::function<void()> tilesReadyCallback;
+
+    // Guards everything below, which is shared with the worker thread
+    CriticalSection lock;
+
+    std::unique_ptr<AudioFormatReader> incomingReader;
+    bool readerChanged = false;
+
+    double sampleRate = 0.0;
+    int64 lengthInSamples = 0;
+
+    uint32 generation = 0;
+    uint32 useCounter = 0;
+
+    std::map<TileKey, Tile> tiles;
+    Array<TileKey> pendingTiles;
+
+    // Only touched by the worker thread
+    std::unique_ptr<AudioFormatReader> reader;
+    dsp::FFT fft { fftOrder };
+    dsp::WindowingFunction<float> window { static_cast<size_t>(fftSize),
+                                           dsp::WindowingFunction<float>::hann };
+    HeapBlock<float> fftData;
+    AudioBuffer<float> readBuffer { 2, fftSize };
+    Array<int> rowBinStart;
+    Array<int> rowBinEnd;
+
+    Colour colourMap[256];
+
+    // Only assigned while there is a reader
+    SharedResourcePointer<SpectrogramWorkerPool> workerPool;
+    TimeSliceThread* workerThread = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramTileCache)
+};
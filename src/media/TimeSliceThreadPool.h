@@ -0,0 +1,101 @@
+/**
+ * @file TimeSliceThreadPool.h
+ * @brief Fixed number of TimeSliceThreads shared by many clients
+ */
+
+#pragma once
+
+#include "juce_core/juce_core.h"
+
+using namespace juce;
+
+/*
+  Each TimeSliceThread already services its clients in order of urgency (a
+  client asks to be called back sooner when it has more to do). A pool
+  therefore only needs to spread clients across a fixed number of threads,
+  so the thread count stays flat no matter how many tracks are open.
+
+  Clients only register with a thread once they need it (e.g., when a
+  BufferingAudioSource is prepared to play), so the pool counts its own
+  assignments rather than the threads' clients. Meant to be used on the
+  message thread.
+*/
+class TimeSliceThreadPool
+{
+public:
+    TimeSliceThreadPool(const String& threadName, Thread::Priority priority)
+        : threadPriority(priority)
+    {
+        int numThreads = jlimit(1, maxNumThreads, SystemStats::getNumCpus() / 2);
+
+        for (int i = 0; i < numThreads; ++i)
+        {
+            threads.add(new TimeSliceThread(threadName + " " + String(i)));
+            numAssigned.add(0);
+        }
+    }
+
+    virtual ~TimeSliceThreadPool()
+    {
+        for (auto* t : threads)
+        {
+            t->stopThread(1000);
+        }
+    }
+
+    // Assign the least busy thread to a new client
+    TimeSliceThread* acquireThread()
+    {
+        int leastBusyIdx = 0;
+
+        for (int i = 1; i < threads.size(); ++i)
+        {
+            if (numAssigned[i] < numAssigned[leastBusyIdx])
+            {
+                leastBusyIdx = i;
+            }
+        }
+
+        TimeSliceThread* leastBusyThread = threads[leastBusyIdx];
+
+        // Threads are only started once they are needed
+        if (! leastBusyThread->isThreadRunning())
+        {
+            leastBusyThread->startThread(threadPriority);
+        }
+
+        numAssigned.set(leastBusyIdx, numAssigned[leastBusyIdx] + 1);
+
+        return leastBusyThread;
+    }
+
+    // Release a thread returned by acquireThread once its client is done with it
+    void releaseThread(TimeSliceThread* thread)
+    {
+        int threadIdx = threads.indexOf(thread);
+
+        if (threadIdx < 0 || numAssigned[threadIdx] == 0)
+        {
+            jassertfalse; // Released more often than acquired
+            return;
+        }
+
+        numAssigned.set(threadIdx, numAssigned[threadIdx] - 1);
+    }
+
+    int getNumThreads() const { return threads.size(); }
+
+    int getNumAssigned(int threadIdx) const { return numAssigned[threadIdx]; }
+
+private:
+    static constexpr int maxNumThreads = 4;
+
+    Thread::Priority threadPriority;
+
+    OwnedArray<TimeSliceThread> threads;
+
+    // Number of clients assigned to each thread
+    Array<int> numAssigned;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimeSliceThreadPool)
+};
@@ -0,0 +1,275 @@
+#include "WaveformTileCache.h"
+
+WaveformTileCache::WaveformTileCache(AudioThumbnail& t,
+                                     Colour c,
+                                     std::function<void()> onTilesReady)
+    : thumbnail(t), colour(c), tilesReadyCallback(std::move(onTilesReady))
+{
+    renderThread->addTimeSliceClient(this);
+}
+
+WaveformTileCache::~WaveformTileCache()
+{
+    // Blocks until any tile currently being rendered for this cache is finished
+    renderThread->removeTimeSliceClient(this);
+
+    cancelPendingUpdate();
+}
+
+void WaveformTileCache::invalidate()
+{
+    const ScopedLock sl(lock);
+
+    // Keep stale tiles around as placeholders until they are re-rendered
+    if (! tiles.empty())
+    {
+        previousTiles = std::move(tiles);
+        previousPixelsPerSecond = currentPixelsPerSecond;
+    }
+
+    tiles.clear();
+    pendingTiles.clear();
+    generation++;
+}
+
+void WaveformTileCache::clear()
+{
+    const ScopedLock sl(lock);
+
+    tiles.clear();
+    previousTiles.clear();
+    pendingTiles.clear();
+    previousPixelsPerSecond = 0.0;
+    generation++;
+}
+
+void WaveformTileCache::draw(Graphics& g, Rectangle<int> bounds, Range<double> visibleRange)
+{
+    if (bounds.isEmpty() || visibleRange.getLength() <= 0.0 || thumbnail.getTotalLength() <= 0.0)
+    {
+        return;
+    }
+
+    Rectangle<int> clipBounds = g.getClipBounds().getIntersection(bounds);
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    // Tiles start on a physical pixel, where they are drawn without resampling
+    auto snapToPhysicalPixel = [scale](float x)
+    { return static_cast<float>(roundToInt(x * scale)) / scale; };
+
+    double pixelsPerSecond = static_cast<double>(bounds.getWidth()) / visibleRange.getLength();
+    double visibleStartX = visibleRange.getStart() * pixelsPerSecond;
+
+    auto xToTileIndex = [visibleStartX, bounds](int x)
+    {
+        return jmax(static_cast<int64>(0),
+                    static_cast<int64>(std::floor(
+                        (visibleStartX + static_cast<double>(x - bounds.getX())) / tileWidth)));
+    };
+
+    int64 firstVisibleIndex = xToTileIndex(bounds.getX());
+    int64 lastVisibleIndex = xToTileIndex(bounds.getRight());
+    int64 firstDrawnIndex = xToTileIndex(clipBounds.getX());
+    int64 lastDrawnIndex = xToTileIndex(clipBounds.getRight());
+
+    bool needsRender = false;
+
+    {
+        const ScopedLock sl(lock);
+
+        setZoomLevel(pixelsPerSecond, bounds.getHeight(), scale);
+
+        for (int64 i = firstDrawnIndex; i <= lastDrawnIndex && ! clipBounds.isEmpty(); ++i)
+        {
+            float tileX = static_cast<float>(static_cast<double>(i * tileWidth) - visibleStartX)
+                          + static_cast<float>(bounds.getX());
+
+            auto it = tiles.find(i);
+
+            if (it != tiles.end())
+            {
+                g.drawImage(it->second,
+                            Rectangle<float>(snapToPhysicalPixel(tileX),
+                                             static_cast<float>(bounds.getY()),
+                                             static_cast<float>(tileWidth),
+                                             static_cast<float>(bounds.getHeight())));
+            }
+            else if (previousPixelsPerSecond > 0.0)
+            {
+                // Stretch tiles from the previous zoom level over the missing tile
+                Graphics::ScopedSaveState state(g);
+                g.reduceClipRegion(Rectangle<float>(tileX,
+                                                    static_cast<float>(bounds.getY()),
+                                                    static_cast<float>(tileWidth),
+                                                    static_cast<float>(bounds.getHeight()))
+                                       .toNearestInt());
+
+                double zoomRatio = pixelsPerSecond / previousPixelsPerSecond;
+
+                for (const auto& [previousIndex, previousTile] : previousTiles)
+                {
+                    double previousX = static_cast<double>(previousIndex * tileWidth) * zoomRatio;
+
+                    float x = static_cast<float>(previousX - visibleStartX)
+                              + static_cast<float>(bounds.getX());
+                    float w = static_cast<float>(tileWidth * zoomRatio);
+
+                    if (x + w >= tileX && x <= tileX + static_cast<float>(tileWidth))
+                    {
+                        g.drawImage(previousTile,
+                                    Rectangle<float>(x,
+                                                     static_cast<float>(bounds.getY()),
+                                                     w,
+                                                     static_cast<float>(bounds.getHeight())));
+                    }
+                }
+            }
+        }
+
+        // Request visible tiles first, then one on each side to hide short scrolls
+        for (int64 i = firstVisibleIndex; i <= lastVisibleIndex; ++i)
+        {
+            requestTile(i);
+        }
+
+        requestTile(firstVisibleIndex - 1);
+        requestTile(lastVisibleIndex + 1);
+
+        evictDistantTiles(firstVisibleIndex, lastVisibleIndex);
+
+        needsRender = ! pendingTiles.isEmpty();
+    }
+
+    if (needsRender)
+    {
+        renderThread->moveToFrontOfQueue(this);
+    }
+}
+
+int WaveformTileCache::useTimeSlice()
+{
+    PendingTile request;
+
+    {
+        const ScopedLock sl(lock);
+
+        if (pendingTiles.isEmpty())
+        {
+            return idleIntervalMs;
+        }
+
+        request = pendingTiles.removeAndReturn(0);
+    }
+
+    // In physical pixels, scaled down when drawn
+    Image tile(Image::ARGB,
+               roundToInt(static_cast<float>(tileWidth) * request.scale),
+               roundToInt(static_cast<float>(request.height) * request.scale),
+               true,
+               SoftwareImageType());
+
+    {
+        Graphics g(tile);
+        g.setColour(colour);
+
+        double tileStartTime =
+            static_cast<double>(request.index * tileWidth) / request.pixelsPerSecond;
+        double tileEndTime =
+            static_cast<double>((request.index + 1) * tileWidth) / request.pixelsPerSecond;
+
+        thumbnail.drawChannels(g, tile.getBounds(), tileStartTime, tileEndTime, 1.0f);
+    }
+
+    {
+        const ScopedLock sl(lock);
+
+        // Drop tiles rendered for a zoom level or thumbnail state that is no longer current
+        if (request.generation != generation)
+        {
+            return 0;
+        }
+
+        tiles[request.index] = tile;
+    }
+
+    triggerAsyncUpdate();
+
+    return 0;
+}
+
+void WaveformTileCache::handleAsyncUpdate()
+{
+    if (tilesReadyCallback)
+    {
+        tilesReadyCallback();
+    }
+}
+
+void WaveformTileCache::setZoomLevel(double pixelsPerSecond, int height, float scale)
+{
+    bool zoomChanged =
+        std::abs(pixelsPerSecond - currentPixelsPerSecond) > 1e-9 * jmax(1.0, pixelsPerSecond);
+
+    if (! zoomChanged && height == currentHeight && approximatelyEqual(scale, currentScale))
+    {
+        return;
+    }
+
+    if (! tiles.empty())
+    {
+        previousTiles = std::move(tiles);
+        previousPixelsPerSecond = currentPixelsPerSecond;
+    }
+
+    tiles.clear();
+    pendingTiles.clear();
+    generation++;
+
+    currentPixelsPerSecond = pixelsPerSecond;
+    currentHeight = height;
+    currentScale = scale;
+}
+
+void WaveformTileCache::requestTile(int64 index)
+{
+    if (index < 0
+        || static_cast<double>(index * tileWidth) / currentPixelsPerSecond
+               > thumbnail.getTotalLength())
+    {
+        return;
+    }
+
+    if (tiles.find(index) != tiles.end())
+    {
+        return;
+    }
+
+    for (const auto& p : pendingTiles)
+    {
+        if (p.index == index)
+        {
+            return;
+        }
+    }
+
+    pendingTiles.add({ index, currentPixelsPerSecond, currentHeight, currentScale, generation });
+}
+
+void WaveformTileCache::evictDistantTiles(int64 firstVisibleIndex, int64 lastVisibleIndex)
+{
+    while (static_cast<int>(tiles.size()) > maxNumTiles)
+    {
+        int64 distanceBefore = firstVisibleIndex - tiles.begin()->first;
+        int64 distanceAfter = tiles.rbegin()->first - lastVisibleIndex;
+
+        if (distanceBefore >= distanceAfter)
+        {
+            tiles.erase(tiles.begin());
+        }
+        else
+        {
+            tiles.erase(std::prev(tiles.end()));
+        }
+    }
+}
@@ -0,0 +1,94 @@
+/**
+ * @file WaveformTileCache.h
+ * @brief Waveform images rendered off the message thread in fixed-width tiles
+ */
+
+#pragma once
+
+#include <juce_audio_utils/juce_audio_utils.h>
+#include <map>
+
+using namespace juce;
+
+// Background thread shared by all waveform tile caches
+class WaveformRenderThread : public TimeSliceThread
+{
+public:
+    WaveformRenderThread() : TimeSliceThread("Waveform Render Thread")
+    {
+        startThread(Thread::Priority::low);
+    }
+
+    ~WaveformRenderThread() override { stopThread(1000); }
+};
+
+/*
+  Tiles are aligned to absolute pixel positions at the current zoom level
+  (pixels per second), so scrolling reuses existing tiles and only zooming,
+  resizing or new thumbnail data requires rendering new ones. Tiles from the
+  previous zoom level are kept and stretched into place until replacements
+  are ready, to avoid flashing an empty waveform while zooming.
+
+  Tiles are rendered at the physical pixel scale of the display and drawn
+  scaled down, so waveforms stay sharp on high-DPI screens. A change of
+  scale (e.g., moving the window to another screen) is handled like a zoom.
+*/
+class WaveformTileCache : private TimeSliceClient, private AsyncUpdater
+{
+public:
+    WaveformTileCache(AudioThumbnail& t, Colour c, std::function<void()> onTilesReady);
+    ~WaveformTileCache() override;
+
+    // Re-render all tiles (e.g., thumbnail contents changed), keeping old ones as placeholders
+    void invalidate();
+
+    // Discard all tiles, including placeholders (e.g., a different file was loaded)
+    void clear();
+
+    // Blit cached tiles for the visible range and queue any that are missing
+    void draw(Graphics& g, Rectangle<int> bounds, Range<double> visibleRange);
+
+private:
+    struct PendingTile
+    {
+        int64 index;
+        double pixelsPerSecond;
+        int height;
+        float scale;
+        uint32 generation;
+    };
+
+    int useTimeSlice() override;
+    void handleAsyncUpdate() override;
+
+    void setZoomLevel(double pixelsPerSecond, int height, float scale);
+    void requestTile(int64 index);
+    void evictDistantTiles(int64 firstVisibleIndex, int64 lastVisibleIndex);
+
+    static constexpr int tileWidth = 256;
+    static constexpr int maxNumTiles = 64;
+    static constexpr int idleIntervalMs = 500;
+
+    AudioThumbnail& thumbnail;
+    const Colour colour;
+    std::function<void()> tilesReadyCallback;
+
+    // Guards everything below, which is shared with the render thread
+    CriticalSection lock;
+
+    uint32 generation = 0;
+
+    double currentPixelsPerSecond = 0.0;
+    int currentHeight = 0;
+    float currentScale = 1.0f;
+    std::map<int64, Image> tiles;
+
+    double previousPixelsPerSecond = 0.0;
+    std::map<int64, Image> previousTiles;
+
+    Array<PendingTile> pendingTiles;
+
+    SharedResourcePointer<WaveformRenderThread> renderThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformTileCache)
+};
@@ -1,5 +1,7 @@
 #include "KeyboardComponent.hpp"
 
+#include "../TraceRecorder.h"
+
 const char* KeyboardComponent::pitchNames[] = {
     "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B",
 };
@@ -7,6 +9,71 @@ const char* KeyboardComponent::pitchNames[] = {
 const Array<int> KeyboardComponent::blackPitches = Array(1, 3, 6, 8, 10);
 
 void KeyboardComponent::paint(Graphics& g)
+{
+    HARP_TRACE_SCOPE("ui", "KeyboardComponent::paint");
+
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    updateKeyCache(isKeyboardComponent() ? getWidth() : backgroundTileWidth, scale);
+
+    if (! keyCache.isValid())
+    {
+        return;
+    }
+
+    if (isKeyboardComponent())
+    {
+        // Only blit the keys which are visible
+        Rectangle<int> clipBounds = g.getClipBounds().getIntersection(getLocalBounds());
+        Rectangle<int> sourceBounds = (clipBounds.toFloat() * scale).getSmallestIntegerContainer();
+
+        g.drawImage(keyCache,
+                    clipBounds.getX(),
+                    clipBounds.getY(),
+                    clipBounds.getWidth(),
+                    clipBounds.getHeight(),
+                    sourceBounds.getX(),
+                    sourceBounds.getY(),
+                    sourceBounds.getWidth(),
+                    sourceBounds.getHeight());
+    }
+    else
+    {
+        g.setFillType(FillType(keyCache, AffineTransform::scale(1.0f / scale)));
+        g.fillRect(g.getClipBounds());
+    }
+}
+
+void KeyboardComponent::updateKeyCache(int width, float scale)
+{
+    if (keyCache.isValid() && keyCacheWidth == width && keyCacheHeight == getHeight()
+        && approximatelyEqual(keyCacheScale, scale))
+    {
+        return;
+    }
+
+    keyCacheWidth = width;
+    keyCacheHeight = getHeight();
+    keyCacheScale = scale;
+
+    int imageWidth = roundToInt(static_cast<float>(width) * scale);
+    int imageHeight = roundToInt(static_cast<float>(getHeight()) * scale);
+
+    if (imageWidth <= 0 || imageHeight <= 0)
+    {
+        keyCache = Image();
+        return;
+    }
+
+    keyCache = Image(Image::ARGB, imageWidth, imageHeight, true);
+
+    Graphics g(keyCache);
+    g.addTransform(AffineTransform::scale(scale));
+
+    drawKeys(g, width);
+}
+
+void KeyboardComponent::drawKeys(Graphics& g, int width)
 {
     const float keyHeight = getKeyHeight();
 
@@ -32,7 +99,7 @@ void KeyboardComponent::paint(Graphics& g)
         }
 
         g.setColour(blackPitches.contains(pitch) ? blackKeyColor : whiteKeyColor);
-        g.fillRect(0, static_cast<int>(cumHeight), getWidth(), static_cast<int>(keyHeight) - 1);
+        g.fillRect(0, static_cast<int>(cumHeight), width, static_cast<int>(keyHeight) - 1);
 
         if (isKeyboardComponent())
         {
@@ -42,7 +109,7 @@ void KeyboardComponent::paint(Graphics& g)
             g.drawText(noteName,
                        5,
                        static_cast<int>(cumHeight),
-                       getWidth(),
+                       width,
                        static_cast<int>(keyHeight - 1.0f),
                        Justification::left);
         }
@@ -50,7 +117,7 @@ void KeyboardComponent::paint(Graphics& g)
         cumHeight += keyHeight;
 
         g.setColour(Colours::black);
-        g.drawLine(0.0f, cumHeight, static_cast<float>(getWidth()), cumHeight);
+        g.drawLine(0.0f, cumHeight, static_cast<float>(width), cumHeight);
     }
 }
 
@@ -19,4 +19,24 @@ public:
     virtual bool isKeyboardComponent() { return true; }
 
     float getKeyHeight();
+
+private:
+    void drawKeys(Graphics& g, int width);
+
+    /*
+      Keys only change with the key height, so they are drawn once into an
+      image, which is rebuilt whenever the height, width or display scale
+      changes. The keyboard blits the part of the image within the clip
+      region, while the note grid (whose width follows the horizontal zoom)
+      tiles a narrow strip of background horizontally.
+    */
+    void updateKeyCache(int width, float scale);
+
+    static constexpr int backgroundTileWidth = 64;
+
+    Image keyCache;
+
+    int keyCacheWidth = 0;
+    int keyCacheHeight = 0;
+    float keyCacheScale = 0.0f;
 };
@@ -1,5 +1,7 @@
 #include "NoteGridComponent.hpp"
 
+#include "../TraceRecorder.h"
+
 NoteGridComponent::NoteGridComponent()
 {
     pixelsPerSecond = 0.0;
@@ -13,23 +15,52 @@ NoteGridComponent::~NoteGridComponent()
 
 void NoteGridComponent::paint(Graphics& g)
 {
+    HARP_TRACE_SCOPE("ui", "NoteGridComponent::paint");
+
     // Paint key background
     KeyboardComponent::paint(g);
 
-    // Paint all notes
-    for (auto n : midiNotes)
+    if (startTimes.empty() || pixelsPerSecond <= 0.0)
+    {
+        return;
+    }
+
+    Rectangle<int> clipBounds = g.getClipBounds();
+
+    const float noteHeight = getKeyHeight();
+    const float minNoteWidth = 3.0f;
+
+    // Earliest start time of a note that can reach into the clip region (allowing for minimum width)
+    double firstTime =
+        static_cast<double>(clipBounds.getX() - minNoteWidth) / pixelsPerSecond - maxDuration;
+    double lastTime = static_cast<double>(clipBounds.getRight()) / pixelsPerSecond;
+
+    auto first = std::lower_bound(startTimes.begin(), startTimes.end(), firstTime);
+    auto last = std::upper_bound(first, startTimes.end(), lastTime);
+
+    size_t firstIdx = static_cast<size_t>(first - startTimes.begin());
+    size_t lastIdx = static_cast<size_t>(last - startTimes.begin());
+
+    noteRects.clear();
+    velocityRects.clear();
+
+    for (size_t i = firstIdx; i < lastIdx; ++i)
     {
-        const float noteWidth = static_cast<float>(n->duration * pixelsPerSecond);
-        const float noteHeight = getKeyHeight();
+        const float noteWidth = static_cast<float>(durations[i] * pixelsPerSecond);
+
+        const float noteXPos = static_cast<float>(startTimes[i] * pixelsPerSecond);
+        const float noteYPos = static_cast<float>(getHeight()) - (noteNumbers[i] * noteHeight);
 
-        const float noteXPos = static_cast<float>(n->startTime * pixelsPerSecond);
-        const float noteYPos = static_cast<float>(getHeight()) - ((n->noteNumber) * noteHeight);
+        Rectangle<float> bounds(
+            noteXPos, noteYPos, jmax(minNoteWidth, noteWidth), noteHeight - 1.0f);
 
-        Rectangle<float> bounds(noteXPos, noteYPos, jmax(3.0f, noteWidth), noteHeight - 1.0f);
+        if (! bounds.intersects(clipBounds.toFloat()))
+        {
+            continue;
+        }
 
         // Note fill
-        g.setColour(Colours::red.brighter().withAlpha(0.75f));
-        g.fillRect(bounds.toNearestInt());
+        noteRects.addWithoutMerging(bounds.toNearestInt());
 
         if ((noteWidth >= 5) & (noteHeight >= 8))
         {
@@ -38,13 +69,18 @@ void NoteGridComponent::paint(Graphics& g)
             const float velocityHeight = 4.0f;
 
             // Velocity fill
-            g.setColour(Colours::red.brighter().brighter());
-            g.fillRect(bounds.translated(2, verticalOffset)
-                           .withWidth(maxVelocityWidth * n->velocity / 127.0f)
-                           .withHeight(velocityHeight)
-                           .toNearestInt());
+            velocityRects.addWithoutMerging(bounds.translated(2, verticalOffset)
+                                                .withWidth(maxVelocityWidth * velocities[i] / 127.0f)
+                                                .withHeight(velocityHeight)
+                                                .toNearestInt());
         }
     }
+
+    g.setColour(Colours::red.brighter().withAlpha(0.75f));
+    g.fillRectList(noteRects);
+
+    g.setColour(Colours::red.brighter().brighter());
+    g.fillRectList(velocityRects);
 }
 
 void NoteGridComponent::setResolution(double pps)
@@ -66,23 +102,70 @@ void NoteGridComponent::updateSize()
     setSize(static_cast<int>(pixelsPerSecond * lengthInSeconds), getHeight());
 }
 
-void NoteGridComponent::insertNote(MidiNote n)
+void NoteGridComponent::insertNotes(const std::vector<MidiNote>& notes)
 {
-    MidiNote* note = new MidiNote(n);
-    midiNotes.add(note);
+    if (notes.empty())
+    {
+        return;
+    }
+
+    size_t numNotes = startTimes.size() + notes.size();
+
+    startTimes.reserve(numNotes);
+    durations.reserve(numNotes);
+    noteNumbers.reserve(numNotes);
+    velocities.reserve(numNotes);
+
+    for (const auto& n : notes)
+    {
+        startTimes.push_back(n.startTime);
+        durations.push_back(n.duration);
+        noteNumbers.push_back(n.noteNumber);
+        velocities.push_back(n.velocity);
+
+        maxDuration = jmax(maxDuration, n.duration);
+    }
+
+    // Notes from a file usually arrive in order already
+    if (! std::is_sorted(startTimes.begin(), startTimes.end()))
+    {
+        std::vector<size_t> order(numNotes);
+        std::iota(order.begin(), order.end(), 0);
+
+        std::stable_sort(order.begin(),
+                         order.end(),
+                         [this](size_t a, size_t b) { return startTimes[a] < startTimes[b]; });
+
+        auto reorder = [&order](auto& values)
+        {
+            std::remove_reference_t<decltype(values)> sorted;
+            sorted.reserve(values.size());
+
+            for (size_t i : order)
+            {
+                sorted.push_back(values[i]);
+            }
+
+            values = std::move(sorted);
+        };
+
+        reorder(startTimes);
+        reorder(durations);
+        reorder(noteNumbers);
+        reorder(velocities);
+    }
 
     repaint();
 }
 
 void NoteGridComponent::resetNotes()
 {
-    for (int i = 0; i < midiNotes.size(); i++)
-    {
-        MidiNote* note = midiNotes.getReference(i);
-        delete note;
-    }
+    startTimes.clear();
+    durations.clear();
+    noteNumbers.clear();
+    velocities.clear();
 
-    midiNotes.clear();
+    maxDuration = 0.0;
 
     repaint();
 }
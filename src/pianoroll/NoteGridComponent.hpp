@@ -47,11 +47,29 @@ public:
 
     void updateSize();
 
-    void insertNote(MidiNote n);
+    // Add many notes at once, with a single repaint
+    void insertNotes(const std::vector<MidiNote>& notes);
     void resetNotes();
 
+    int getNumNotes() const { return static_cast<int>(startTimes.size()); }
+
 private:
-    Array<MidiNote*> midiNotes;
+    /*
+      Notes are stored as parallel arrays sorted by start time, together with
+      the longest duration. Any note overlapping a time range must then start
+      within that range extended backwards by the longest duration, so painting
+      only needs a binary search to find the notes in the clip region.
+    */
+    std::vector<double> startTimes;
+    std::vector<double> durations;
+    std::vector<unsigned char> noteNumbers;
+    std::vector<unsigned char> velocities;
+
+    double maxDuration = 0.0;
+
+    // Reused across paint calls to batch fills by colour
+    RectangleList<int> noteRects;
+    RectangleList<int> velocityRects;
 
     double pixelsPerSecond;
     double lengthInSeconds;
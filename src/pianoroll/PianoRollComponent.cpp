@@ -1,5 +1,7 @@
 #include "PianoRollComponent.hpp"
 
+#include "../TraceRecorder.h"
+
 PianoRollComponent::PianoRollComponent(int kbw, int prs, int sbsz, int sbsp, bool hk, bool hC)
     : keyboardWidth(kbw),
       pianoRollSpacing(prs),
@@ -41,6 +43,8 @@ PianoRollComponent::~PianoRollComponent()
 
 void PianoRollComponent::resized()
 {
+    HARP_TRACE_SCOPE("ui", "PianoRollComponent::resized");
+
     // Perform component resizing
     keyboardContainer.setBounds(getLocalBounds().removeFromLeft(getKeyboardWidth()));
     noteGridContainer.setBounds(getLocalBounds()
@@ -47,7 +47,7 @@ public:
 
     void resizeNoteGrid(double lengthInSecs);
 
-    void insertNote(MidiNote n) { noteGrid.insertNote(n); }
+    void insertNotes(const std::vector<MidiNote>& notes) { noteGrid.insertNotes(notes); }
     void resetNotes() { noteGrid.resetNotes(); }
 
     void updateVisibleMediaRange(Range<double> newRange);
@@ -1,7 +1,14 @@
+#pragma once
+
 // See https://juce.com/tutorials/tutorial_synth_using_midi_input/ for details
 
 #include <juce_audio_basics/juce_audio_basics.h>
 
+#include <atomic>
+#include <limits>
+
+using namespace juce;
+
 struct SineWaveSound : public SynthesiserSound
 {
     SineWaveSound() {}
@@ -10,6 +17,12 @@ struct SineWaveSound : public SynthesiserSound
     bool appliesToChannel(int) override { return true; }
 };
 
+/*
+  Renders in chunks rather than sample by sample. Within a chunk the sinusoid
+  comes from a two-term recursion, which also applies the exponential release
+  when the note is tailing off, so std::sin is only evaluated twice per chunk.
+  The chunk is then mixed into each output channel with a vectorised add.
+*/
 struct SineWaveVoice : public SynthesiserVoice
 {
     SineWaveVoice() {}
@@ -52,71 +65,138 @@ struct SineWaveVoice : public SynthesiserVoice
         }
     }
 
+    // Phase a held note reaches after the given number of samples (its level stays constant)
+    void skipAhead(int64 numSamples)
+    {
+        currentAngle =
+            std::fmod(static_cast<double>(numSamples) * angleDelta, 2.0 * MathConstants<double>::pi);
+    }
+
     void pitchWheelMoved(int) override {}
     void controllerMoved(int, int) override {}
 
     void renderNextBlock(AudioSampleBuffer& outputBuffer, int startSample, int numSamples) override
     {
-        if (angleDelta != 0.0)
+        while (angleDelta != 0.0 && numSamples > 0)
         {
-            if (tailOff > 0.0)
+            int numToRender = jmin(numSamples, maxChunkSize);
+
+            bool isTailingOff = tailOff > 0.0;
+            bool isFinished = false;
+
+            if (isTailingOff)
             {
-                while (--numSamples >= 0)
+                // Number of samples until the release falls below the silence threshold
+                int numUntilSilent = jmax(
+                    1,
+                    static_cast<int>(std::ceil(std::log(silenceThreshold / tailOff)
+                                               / std::log(tailOffPerSample))));
+
+                if (numUntilSilent <= numToRender)
                 {
-                    float currentSample =
-                        static_cast<float>(std::sin(currentAngle) * level * tailOff);
+                    numToRender = numUntilSilent;
+                    isFinished = true;
+                }
+            }
 
-                    for (int i = outputBuffer.getNumChannels(); --i >= 0;)
-                    {
-                        outputBuffer.addSample(i, startSample, currentSample);
-                    }
+            renderChunk(numToRender, isTailingOff);
 
-                    currentAngle += angleDelta;
+            for (int i = outputBuffer.getNumChannels(); --i >= 0;)
+            {
+                FloatVectorOperations::add(
+                    outputBuffer.getWritePointer(i, startSample), chunk.data(), numToRender);
+            }
+
+            startSample += numToRender;
+            numSamples -= numToRender;
 
-                    ++startSample;
+            if (isFinished)
+            {
+                clearCurrentNote();
 
-                    tailOff *= 0.99;
+                angleDelta = 0.0;
+            }
+        }
+    }
 
-                    if (tailOff <= 0.005)
-                    {
-                        clearCurrentNote();
+private:
+    /*
+      x[n] = g * r^n * sin(angle + n * delta) satisfies
+      x[n] = 2 * r * cos(delta) * x[n - 1] - r^2 * x[n - 2],
+      with r = 1 for held notes and r = tailOffPerSample during release.
+    */
+    void renderChunk(int numToRender, bool isTailingOff)
+    {
+        double r = isTailingOff ? tailOffPerSample : 1.0;
+        double gain = isTailingOff ? level * tailOff : level;
 
-                        angleDelta = 0.0;
+        double coefficient = 2.0 * r * std::cos(angleDelta);
+        double rSquared = r * r;
 
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                while (--numSamples >= 0)
-                {
-                    auto currentSample = static_cast<float>(std::sin(currentAngle) * level);
+        double previous = gain * std::sin(currentAngle - angleDelta) / r;
+        double current = gain * std::sin(currentAngle);
 
-                    for (auto i = outputBuffer.getNumChannels(); --i >= 0;)
-                    {
-                        outputBuffer.addSample(i, startSample, currentSample);
-                    }
+        for (int n = 0; n < numToRender; ++n)
+        {
+            chunk[static_cast<size_t>(n)] = static_cast<float>(current);
 
-                    currentAngle += angleDelta;
+            double next = coefficient * current - rSquared * previous;
 
-                    ++startSample;
-                }
-            }
+            previous = current;
+            current = next;
+        }
+
+        // Restart the recursion from exact values for the next chunk, to avoid drift
+        currentAngle = std::fmod(currentAngle + angleDelta * numToRender,
+                                 2.0 * MathConstants<double>::pi);
+
+        if (isTailingOff)
+        {
+            tailOff *= std::pow(tailOffPerSample, numToRender);
         }
     }
 
-private:
+    static constexpr int maxChunkSize = 256;
+
+    static constexpr double tailOffPerSample = 0.99;
+    static constexpr double silenceThreshold = 0.005;
+
     double currentAngle = 0.0;
     double angleDelta = 0.0;
     double tailOff = 0.0;
     double level = 0.0;
+
+    std::array<float, maxChunkSize> chunk;
 };
 
+/*
+  Events are kept in time order alongside their positions in samples, and a
+  cursor marks the next event to be played. Each block only visits the events
+  it contains, and seeking is a binary search, so the cost of a callback does
+  not depend on the length of the sequence. Nothing is allocated on the audio
+  thread, as long as a block does not hold more events than the MIDI buffer was
+  sized for (see updateMidiBufferSize).
+
+  Seeks may come from any thread. They are only published as a pending
+  position, and the audio thread moves the cursor at the start of its next
+  block, so the cursor is never touched by two threads at once.
+*/
 class SynthAudioSource : public PositionableAudioSource
 {
 public:
-    SynthAudioSource() { synth.addSound(new SineWaveSound()); }
+    SynthAudioSource()
+    {
+        synth.addSound(new SineWaveSound());
+
+        // Fixed pool, so neither memory nor per-block cost depend on the file being played
+        for (int i = 0; i < voiceBudget; ++i)
+        {
+            synth.addVoice(new SineWaveVoice());
+        }
+
+        // Once the pool is exhausted, the oldest notes are released to make room for new ones
+        synth.setNoteStealingEnabled(true);
+    }
 
     void setUsingSineWaveSound() { synth.clearSounds(); }
 
@@ -129,83 +209,93 @@ public:
         synth.setCurrentPlaybackSampleRate(sr);
         sampleRate = sr;
         samplesPerBlock = samplesPerBlockExpected;
+
+        updateEventSamples();
+        updateMidiBufferSize();
     }
 
     void releaseResources() override {}
 
     void useSequence(MidiMessageSequence midiSequence)
     {
-        sequence = midiSequence;
+        eventMessages.clear();
+        eventTimes.clear();
 
-        int maxVoices = 0;
-        int currVoices = 0;
+        eventMessages.reserve(static_cast<size_t>(midiSequence.getNumEvents()));
+        eventTimes.reserve(static_cast<size_t>(midiSequence.getNumEvents()));
 
-        // Get max number of voices needed and add that many voices
-        for (int eventIdx = 0; eventIdx < sequence.getNumEvents(); ++eventIdx)
+        for (int eventIdx = 0; eventIdx < midiSequence.getNumEvents(); ++eventIdx)
         {
-            const auto midiEvent = sequence.getEventPointer(eventIdx);
+            const auto midiEvent = midiSequence.getEventPointer(eventIdx);
             const auto& midiMessage = midiEvent->message;
 
             double startTime = midiEvent->message.getTimeStamp();
 
             lastStartTime = startTime;
 
-            if (midiMessage.isNoteOn())
-            {
-                currVoices++;
-                if (currVoices > maxVoices)
-                {
-                    maxVoices = currVoices;
-                }
-            }
-
-            if (midiMessage.isNoteOff())
-            {
-                currVoices--;
-            }
+            eventMessages.push_back(midiMessage);
+            eventTimes.push_back(startTime);
         }
 
-        //DBG("SynthAudioSource::useSequence Max voices set to " << maxVoices << ".");
+        // MidiMessageSequence keeps its events sorted, which the cursor relies on
+        jassert(std::is_sorted(eventTimes.begin(), eventTimes.end()));
 
-        synth.clearVoices();
+        eventSamples.resize(eventTimes.size());
 
-        for (auto i = 0; i < maxVoices; ++i)
-        {
-            synth.addVoice(new SineWaveVoice());
-        }
+        updateEventSamples();
+        updateMidiBufferSize();
+
+        // Notes of the previous sequence should not keep voices from the pool busy
+        synth.allNotesOff(0, false);
     }
 
     void getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill) override
     {
         bufferToFill.clearActiveBufferRegion();
 
-        MidiBuffer incomingMidi;
+        midiBuffer.clear();
 
-        int64 lastSample = readPosition + samplesPerBlock;
+        if (int64 seek = pendingSeek.exchange(noPendingSeek); seek != noPendingSeek)
+        {
+            moveCursor(seek);
+        }
 
-        for (int eventIdx = 0; eventIdx < sequence.getNumEvents(); ++eventIdx)
+        int64 readPosition = currentPosition.load();
+        int64 endSample = readPosition + bufferToFill.numSamples;
+
+        size_t numEvents = eventSamples.size();
+
+        while (nextEventIdx < numEvents && eventSamples[nextEventIdx] < endSample)
         {
-            const auto midiEvent = sequence.getEventPointer(eventIdx);
-            const auto& midiMessage = midiEvent->message;
+            // Synthesiser expects positions within the output buffer
+            int samplePosition =
+                bufferToFill.startSample
+                + static_cast<int>(jmax<int64>(0, eventSamples[nextEventIdx] - readPosition));
 
-            int startTimeSamples = secondsToSamples(midiEvent->message.getTimeStamp());
+            midiBuffer.addEvent(eventMessages[nextEventIdx], samplePosition);
 
-            if (startTimeSamples >= readPosition && startTimeSamples <= lastSample)
-            {
-                incomingMidi.addEvent(midiMessage,
-                                      static_cast<int>(startTimeSamples - readPosition));
-            }
+            ++nextEventIdx;
         }
 
         synth.renderNextBlock(
-            *bufferToFill.buffer, incomingMidi, bufferToFill.startSample, bufferToFill.numSamples);
+            *bufferToFill.buffer, midiBuffer, bufferToFill.startSample, bufferToFill.numSamples);
+
+        currentPosition = endSample;
+    }
 
-        readPosition += samplesPerBlock;
+    void setNextReadPosition(int64 newPosition) override
+    {
+        jassert(newPosition != noPendingSeek);
+
+        pendingSeek = newPosition;
     }
 
-    void setNextReadPosition(int64 newPosition) override { readPosition = newPosition; }
+    int64 getNextReadPosition() const override
+    {
+        int64 seek = pendingSeek.load();
 
-    int64 getNextReadPosition() const override { return readPosition; }
+        return seek != noPendingSeek ? seek : currentPosition.load();
+    }
 
     int64 getTotalLength() const override
     {
@@ -218,15 +308,140 @@ public:
 
     void resetNotes() { synth.allNotesOff(0, false); }
 
+    void setSustainPedal(int midiChannel, bool isDown)
+    {
+        synth.handleSustainPedal(midiChannel, isDown);
+    }
+
+    /*
+      Starts a note as if it had been playing for the given number of samples,
+      so an offline render can begin in the middle of it. If the key is no
+      longer down, the note is left to the sustain pedal.
+    */
+    void resumeNote(int midiChannel,
+                    int noteNumber,
+                    float velocity,
+                    int64 numSamplesPlayed,
+                    bool isKeyDown)
+    {
+        synth.noteOn(midiChannel, noteNumber, velocity);
+
+        SynthesiserVoice* resumedVoice = nullptr;
+
+        // Latest voice on the key, as an earlier one may still be tailing off
+        for (int i = 0; i < synth.getNumVoices(); ++i)
+        {
+            SynthesiserVoice* voice = synth.getVoice(i);
+
+            if (voice->getCurrentlyPlayingNote() == noteNumber
+                && voice->isPlayingChannel(midiChannel)
+                && (resumedVoice == nullptr || resumedVoice->wasStartedBefore(*voice)))
+            {
+                resumedVoice = voice;
+            }
+        }
+
+        if (auto* sineVoice = dynamic_cast<SineWaveVoice*>(resumedVoice))
+        {
+            sineVoice->skipAhead(numSamplesPlayed);
+        }
+
+        if (! isKeyDown)
+        {
+            synth.noteOff(midiChannel, noteNumber, 0.0f, true);
+        }
+    }
+
+    /*
+      Number of voices to keep. A voice costs a few operations per sample, so
+      this many stay well within the budget of a single audio callback on any
+      machine. It is fixed, as notes are stolen once it is exhausted and
+      bounces must sound the same wherever they are rendered.
+    */
+    static constexpr int voiceBudget = 32;
+
 private:
-    int secondsToSamples(double secondsTime) const { return (int) (secondsTime * sampleRate); }
+    // Called on the audio thread only
+    void moveCursor(int64 newPosition)
+    {
+        currentPosition = newPosition;
+
+        // Move cursor to the first event at or after the new position
+        nextEventIdx = static_cast<size_t>(
+            std::lower_bound(eventSamples.begin(), eventSamples.end(), newPosition)
+            - eventSamples.begin());
+    }
+
+    int64 secondsToSamples(double secondsTime) const
+    {
+        return static_cast<int64>(secondsTime * sampleRate);
+    }
+
+    // Recompute event positions for the current sample rate (sizes never change here)
+    void updateEventSamples()
+    {
+        for (size_t i = 0; i < eventTimes.size(); ++i)
+        {
+            eventSamples[i] = secondsToSamples(eventTimes[i]);
+        }
+
+        // The cursor is found again for the new positions on the next block
+        setNextReadPosition(getNextReadPosition());
+    }
+
+    /*
+      Reserve enough space in the MIDI buffer for the busiest stretch of the
+      sequence, measured over a window of two blocks to leave room for devices
+      which deliver blocks larger than they announce.
+    */
+    void updateMidiBufferSize()
+    {
+        // Each event is stored with a timestamp and a size next to its data
+        const size_t headerSize = sizeof(int32) + sizeof(uint16);
+
+        int64 windowSize = 2 * static_cast<int64>(jmax(1, samplesPerBlock));
+
+        size_t windowBytes = 0;
+        size_t maxWindowBytes = 0;
+
+        for (size_t first = 0, last = 0; last < eventSamples.size(); ++last)
+        {
+            windowBytes += headerSize + static_cast<size_t>(eventMessages[last].getRawDataSize());
+
+            while (eventSamples[last] - eventSamples[first] >= windowSize)
+            {
+                windowBytes -=
+                    headerSize + static_cast<size_t>(eventMessages[first].getRawDataSize());
+                ++first;
+            }
+
+            maxWindowBytes = jmax(maxWindowBytes, windowBytes);
+        }
+
+        midiBuffer.ensureSize(maxWindowBytes);
+    }
+
+    double sampleRate = 44100.0;
+    int samplesPerBlock = 512;
+
+    static constexpr int64 noPendingSeek = std::numeric_limits<int64>::min();
+
+    // Position of the next block, and a seek requested since the last one
+    std::atomic<int64> currentPosition { 0 };
+    std::atomic<int64> pendingSeek { noPendingSeek };
+
+    double lastStartTime = 0.0;
+
+    // Sequence flattened for the audio thread, in time order
+    std::vector<MidiMessage> eventMessages;
+    std::vector<double> eventTimes;
+    std::vector<int64> eventSamples;
 
-    double sampleRate;
-    int samplesPerBlock;
-    int64 readPosition;
+    // Index of the next event to be played
+    size_t nextEventIdx = 0;
 
-    double lastStartTime;
+    // Reused for every block
+    MidiBuffer midiBuffer;
 
-    MidiMessageSequence sequence;
     Synthesiser synth;
 };
@@ -63,18 +63,22 @@ LoginTab::LoginTab(const juce::String& providerName, WebModel* m)
     juce::String savedToken = AppSettings::getString(getStorageKey());
     if (savedToken.isNotEmpty())
     {
-        OpResult result = validateToken(savedToken);
-        if (result.failed())
-        {
-            setStatus("Saved token invalid. Please apply for another token.");
-            forgetButton.setEnabled(true);
-        }
-        else
-        {
-            userToken.setText(savedToken);
-            setStatus("Token verified.");
-            forgetButton.setEnabled(true);
-        }
+        setStatus("Verifying saved token...");
+        forgetButton.setEnabled(true);
+
+        validateTokenAsync(savedToken,
+                           [this, savedToken](OpResult result)
+                           {
+                               if (result.failed())
+                               {
+                                   setStatus("Saved token invalid. Please apply for another token.");
+                               }
+                               else
+                               {
+                                   userToken.setText(savedToken);
+                                   setStatus("Token verified.");
+                               }
+                           });
     }
     else
     {
@@ -114,7 +118,7 @@ juce::String LoginTab::getStorageKey()
     }
 }
 
-OpResult LoginTab::validateToken(const juce::String& token)
+OpResult LoginTab::validateToken(LoginTab::Provider provider, const juce::String& token)
 {
     switch (provider)
     {
@@ -132,66 +136,98 @@ OpResult LoginTab::validateToken(const juce::String& token)
     }
 }
 
+void LoginTab::validateTokenAsync(const juce::String& token,
+                                  std::function<void(OpResult)> onValidated)
+{
+    juce::Component::SafePointer<LoginTab> safeThis(this);
+
+    // Validation is a request to the provider, which must not block the message thread
+    scheduler->submit(TaskScheduler::Lane::Network,
+                      [safeThis, onValidated, token, p = provider]
+                      {
+                          OpResult result = validateToken(p, token);
+
+                          juce::MessageManager::callAsync(
+                              [safeThis, onValidated, result]
+                              {
+                                  if (safeThis != nullptr)
+                                  {
+                                      onValidated(result);
+                                  }
+                              });
+                      });
+}
+
 void LoginTab::handleSubmit()
 {
     auto token = userToken.getText().trim();
     if (token.isNotEmpty())
     {
-        // Validate token
-        OpResult result = validateToken(token);
+        setStatus("Verifying token...");
+        submitButton.setEnabled(false);
+
+        validateTokenAsync(token,
+                           [this, token](OpResult result)
+                           {
+                               submitButton.setEnabled(true);
+                               handleValidationResult(token, result);
+                           });
+    }
+    else
+    {
+        setStatus("No token entered.");
+    }
+}
 
-        if (result.failed())
+void LoginTab::handleValidationResult(const juce::String& token, OpResult result)
+{
+    if (result.failed())
+    {
+        Error err = result.getError();
+        Error::fillUserMessage(err);
+        LogAndDBG("Invalid token:\n" + err.devMessage.toStdString(), LogLevel::Warning);
+        AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,
+                                         "Invalid Token",
+                                         "The provided token is invalid:\n" + err.userMessage);
+        juce::String savedToken = AppSettings::getString(getStorageKey());
+        if (savedToken.isNotEmpty())
         {
-            Error err = result.getError();
-            Error::fillUserMessage(err);
-            LogAndDBG("Invalid token:\n" + err.devMessage.toStdString());
-            AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon,
-                                             "Invalid Token",
-                                             "The provided token is invalid:\n" + err.userMessage);
-            juce::String savedToken = AppSettings::getString(getStorageKey());
-            if (savedToken.isNotEmpty())
-            {
-                userToken.setText(savedToken);
-                setStatus("Invalid token. Saved token restored.");
-            }
-            else
-            {
-                userToken.clear();
-                submitButton.setEnabled(false);
-                setStatus("Invalid token.");
-            }
+            userToken.setText(savedToken);
+            setStatus("Invalid token. Saved token restored.");
         }
         else
         {
-            if (currentlyLoadedModel->ready())
-            {
-                auto& client = currentlyLoadedModel->getClient();
+            userToken.clear();
+            submitButton.setEnabled(false);
+            setStatus("Invalid token.");
+        }
+    }
+    else
+    {
+        if (currentlyLoadedModel->ready())
+        {
+            auto& client = currentlyLoadedModel->getClient();
 
-                if (dynamic_cast<GradioClient*>(&client))
+            if (dynamic_cast<GradioClient*>(&client))
+            {
+                if (provider == LoginTab::Provider::HUGGINGFACE)
                 {
-                    if (provider == LoginTab::Provider::HUGGINGFACE)
-                    {
-                        client.setToken(token);
-                    }
+                    client.setToken(token);
                 }
-                else if (dynamic_cast<StabilityClient*>(&client))
+            }
+            else if (dynamic_cast<StabilityClient*>(&client))
+            {
+                if (provider == LoginTab::Provider::STABILITY)
                 {
-                    if (provider == LoginTab::Provider::STABILITY)
-                    {
-                        client.setToken(token);
-                    }
+                    client.setToken(token);
                 }
             }
-
-            AppSettings::setValue(getStorageKey(), token);
-            AppSettings::saveIfNeeded();
-            setStatus("Token verified and saved.");
-            forgetButton.setEnabled(true);
         }
-    }
-    else
-    {
-        setStatus("No token entered.");
+
+        AppSettings::setValue(getStorageKey(), token);
+        AppSettings::saveIfNeeded();
+        setStatus("Token verified and saved.");
+        forgetButton.setEnabled(true);
     }
 }
 
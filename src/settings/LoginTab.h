@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../TaskScheduler.h"
 #include "../WebModel.h"
 #include "../client/GradioClient.h"
 #include "../client/StabilityClient.h"
@@ -36,13 +37,19 @@ private:
     juce::TextButton submitButton { "Submit" };
     juce::TextButton forgetButton { "Remove Token" };
 
+    juce::SharedResourcePointer<TaskScheduler> scheduler;
+
     LoginTab::Provider getProvider(const juce::String& providerName);
     juce::String getStorageKey();
     juce::URL getTokenURL();
-    OpResult validateToken(const juce::String& token);
+    static OpResult validateToken(LoginTab::Provider provider, const juce::String& token);
+
+    // Validates on a network thread, then calls back on the message thread
+    void validateTokenAsync(const juce::String& token, std::function<void(OpResult)> onValidated);
 
     void handleForget();
     void handleSubmit();
+    void handleValidationResult(const juce::String& token, OpResult result);
 
     void setStatus(juce::String text);
 
@@ -0,0 +1,126 @@
+/*
+ * @file LazyTrackComponent.h
+ * @brief Placeholder for a track whose media display is only created while it is needed.
+ */
+
+#pragma once
+
+#include "juce_gui_basics/juce_gui_basics.h"
+
+#include "../media/MediaDisplayComponent.h"
+#include "../utils.h"
+
+using namespace juce;
+
+/*
+  A media display owns a transport, an audio callback, buttons, scrollbars and
+  (for MIDI) a full pianoroll, which adds up quickly for a clipboard holding
+  hundreds of files. This component only keeps what is needed to recreate the
+  display, plus a snapshot of how it last looked. The owning track area decides
+  when to attach a display (see TrackAreaWidget::updateLazyTracks).
+*/
+class LazyTrackComponent : public Component
+{
+public:
+    LazyTrackComponent(ComponentInfo info, URL path, String name, bool fromDAW)
+        : componentInfo(info), filePath(path), trackName(name), linkedToDAW(fromDAW)
+    {
+    }
+
+    const ComponentInfo& getComponentInfo() const { return componentInfo; }
+    URL getFilePath() const { return filePath; }
+    bool isLinkedToDAW() const { return linkedToDAW; }
+
+    String getTrackName() const
+    {
+        return display != nullptr ? display->getTrackName() : trackName;
+    }
+
+    bool isDuplicateFile(const URL& otherPath) const { return filePath == otherPath; }
+
+    MediaDisplayComponent* getDisplay() const { return display.get(); }
+
+    void setDisplay(std::unique_ptr<MediaDisplayComponent> newDisplay)
+    {
+        display = std::move(newDisplay);
+
+        addAndMakeVisible(display.get());
+        resized();
+
+        snapshot = Image();
+    }
+
+    std::unique_ptr<MediaDisplayComponent> releaseDisplay()
+    {
+        if (display == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Name may have been changed while the display existed
+        trackName = display->getTrackName();
+
+        // Partially loaded media would make for a misleading placeholder
+        if (! display->isLoading() && isShowing())
+        {
+            snapshot = display->createComponentSnapshot(display->getLocalBounds());
+        }
+
+        removeChildComponent(display.get());
+        repaint();
+
+        return std::move(display);
+    }
+
+    // Called when the placeholder is clicked while no display is attached
+    std::function<void()> onPlaceholderClicked;
+
+    void paint(Graphics& g) override
+    {
+        if (display != nullptr)
+        {
+            return;
+        }
+
+        if (snapshot.isValid())
+        {
+            g.drawImage(snapshot, getLocalBounds().toFloat(), RectanglePlacement::stretchToFit);
+        }
+        else
+        {
+            g.fillAll(Colours::darkgrey.darker());
+
+            g.setColour(Colours::white.withAlpha(0.6f));
+            g.setFont(14.0f);
+            g.drawFittedText(trackName, getLocalBounds().reduced(6), Justification::centredLeft, 1);
+        }
+    }
+
+    void resized() override
+    {
+        if (display != nullptr)
+        {
+            display->setBounds(getLocalBounds());
+        }
+    }
+
+    void mouseUp(const MouseEvent& /*e*/) override
+    {
+        if (display == nullptr && onPlaceholderClicked)
+        {
+            onPlaceholderClicked();
+        }
+    }
+
+private:
+    const ComponentInfo componentInfo;
+    const URL filePath;
+
+    String trackName;
+    bool linkedToDAW;
+
+    std::unique_ptr<MediaDisplayComponent> display;
+
+    // How the display looked when it was last released
+    Image snapshot;
+};
@@ -9,7 +9,10 @@
 #include "juce_gui_basics/juce_gui_basics.h"
 
 #include "TrackAreaWidget.h"
+#include "../FileMaterializer.h"
 #include "../gui/MultiButton.h"
+#include "../gui/StatusComponent.h"
+#include "../media/AudioTranscoder.h"
 #include "../utils.h"
 
 using namespace juce;
@@ -242,7 +245,9 @@ public:
                                     }*/
 
                                     if (originalFile.getFileExtension()
-                                        != selectedFile.getFileExtension())
+                                            != selectedFile.getFileExtension()
+                                        && ! AudioTranscoder::canTranscode(selectedFile,
+                                                                           originalFile))
                                     {
                                         AlertWindow::showMessageBoxAsync(
                                             AlertWindow::WarningIcon,
@@ -252,33 +257,10 @@ public:
                                                 + "\" with file of type \""
                                                 + selectedFile.getFileExtension() + "\".",
                                             "OK");
-
-                                        // TODO - perform conversion if possible
                                     }
                                     else
                                     {
-                                        if (selectedFile.copyFileTo(originalFile))
-                                        {
-                                            DBG("MediaClipboardWidget::sendToDAWCallback: Overwriting file "
-                                                << originalFile.getFullPathName() << " with "
-                                                << selectedFile.getFullPathName() << ".");
-
-                                            // Update display with overwritten media
-                                            linkedDisplays[selectedIndex]->initializeDisplay(
-                                                URL(originalFile));
-
-                                            // Remove selected track
-                                            removeSelectionCallback();
-
-                                            // Select overwritten track
-                                            linkedDisplays[selectedIndex]->selectTrack();
-                                        }
-                                        else
-                                        {
-                                            DBG("MediaClipboardWidget::sendToDAWCallback: Failed to overwrite file "
-                                                << originalFile.getFullPathName() << " with "
-                                                << selectedFile.getFullPathName() << ".");
-                                        }
+                                        sendFileToDAW(selectedFile, selectedTrack, originalTrack);
                                     }
                                 }
                             }
@@ -288,6 +270,96 @@ public:
     }
 
 private:
+    /*
+      Replace the file of a DAW-linked track, which the DAW only ever sees
+      complete. Files of another type are converted to the linked file's
+      format in the background first.
+    */
+    void sendFileToDAW(const File& selectedFile,
+                       MediaDisplayComponent* selectedTrack,
+                       MediaDisplayComponent* originalTrack)
+    {
+        File originalFile = originalTrack->getOriginalFilePath().getLocalFile();
+
+        bool needsConversion = originalFile.getFileExtension() != selectedFile.getFileExtension();
+
+        Component::SafePointer<MediaClipboardWidget> safeThis(this);
+        Component::SafePointer<MediaDisplayComponent> safeSelectedTrack(selectedTrack);
+        Component::SafePointer<MediaDisplayComponent> safeOriginalTrack(originalTrack);
+
+        auto onProgress = [safeThis, originalFile, needsConversion](double progress)
+        {
+            if (safeThis != nullptr)
+            {
+                safeThis->statusBox->setStatusMessage(
+                    String(needsConversion ? "Converting" : "Sending") + " file to "
+                    + originalFile.getFullPathName() + " ("
+                    + String(roundToInt(progress * 100.0)) + "%)...");
+            }
+        };
+
+        auto onFinished =
+            [safeThis, safeSelectedTrack, safeOriginalTrack, selectedFile, originalFile](
+                bool sendSuccessful)
+            {
+                if (! sendSuccessful)
+                {
+                    DBG("MediaClipboardWidget::sendFileToDAW: Failed to overwrite file "
+                        << originalFile.getFullPathName() << " with "
+                        << selectedFile.getFullPathName() << ".");
+
+                    if (safeThis != nullptr)
+                    {
+                        safeThis->statusBox->setStatusMessage(
+                            "Failed to send file to " + originalFile.getFullPathName() + ".");
+                    }
+
+                    return;
+                }
+
+                DBG("MediaClipboardWidget::sendFileToDAW: Overwrote file "
+                    << originalFile.getFullPathName() << " with "
+                    << selectedFile.getFullPathName() << ".");
+
+                if (safeThis == nullptr || safeOriginalTrack == nullptr)
+                {
+                    return;
+                }
+
+                // Update display with overwritten media
+                safeOriginalTrack->initializeDisplay(URL(originalFile));
+
+                // Remove selected track, unless the selection changed in the meantime
+                if (safeSelectedTrack != nullptr
+                    && safeThis->trackAreaWidget.getCurrentlySelectedDisplay()
+                           == safeSelectedTrack.getComponent())
+                {
+                    safeThis->removeSelectionCallback();
+                }
+
+                // Select overwritten track
+                safeOriginalTrack->selectTrack();
+            };
+
+        if (needsConversion)
+        {
+            fileMaterializer->writeAsync(
+                originalFile,
+                [selectedFile, originalFile](const File& stagedFile,
+                                             const std::function<void(double)>& reportProgress)
+                {
+                    return AudioTranscoder::transcodeToMatch(
+                        selectedFile, originalFile, stagedFile, reportProgress);
+                },
+                onProgress,
+                onFinished);
+        }
+        else
+        {
+            fileMaterializer->materializeAsync(selectedFile, originalFile, onProgress, onFinished);
+        }
+    }
+
     void initializeButtons()
     {
         /*
@@ -626,4 +698,7 @@ private:
     std::unique_ptr<FileChooser> chooseFileBrowser;
 
     MediaDisplayComponent* currentlySelectedDisplay;
+
+    SharedResourcePointer<FileMaterializer> fileMaterializer;
+    SharedResourcePointer<StatusBox> statusBox;
 };
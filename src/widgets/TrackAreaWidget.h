@@ -12,13 +12,15 @@
 #include "../media/MediaDisplayComponent.h"
 #include "../media/MidiDisplayComponent.h"
 #include "../utils.h"
+#include "LazyTrackComponent.h"
 
 using namespace juce;
 
 class TrackAreaWidget : public Component,
                         public ChangeListener,
                         public ChangeBroadcaster,
-                        public FileDragAndDropTarget
+                        public FileDragAndDropTarget,
+                        private AsyncUpdater
 {
 public:
     TrackAreaWidget(DisplayMode mode = DisplayMode::Input, int trackHeight = 0)
@@ -42,9 +44,9 @@ public:
 
         if (getNumTracks() > 0)
         {
-            for (auto& m : mediaDisplays)
+            for (auto* t : getTrackComponents())
             {
-                FlexItem i = FlexItem(*m);
+                FlexItem i = FlexItem(*t);
 
                 if (fixedTrackHeight)
                 {
@@ -90,8 +92,13 @@ public:
         }
 
         mainBox.performLayout(getLocalBounds());
+
+        triggerAsyncUpdate();
     }
 
+    // Viewport scrolling moves this component within its parent
+    void moved() override { triggerAsyncUpdate(); }
+
     std::vector<std::unique_ptr<MediaDisplayComponent>>& getMediaDisplays()
     {
         return mediaDisplays;
@@ -99,11 +106,11 @@ public:
 
     MediaDisplayComponent* getCurrentlySelectedDisplay()
     {
-        for (auto& m : mediaDisplays)
+        for (auto* m : getExistingDisplays())
         {
             if (m->isCurrentlySelected())
             {
-                return m.get();
+                return m;
             }
         }
 
@@ -114,18 +121,22 @@ public:
     {
         std::vector<MediaDisplayComponent*> linkedDisplays;
 
-        for (auto& m : mediaDisplays)
+        // DAW-linked lazy tracks always keep their display (see updateLazyTracks)
+        for (auto* m : getExistingDisplays())
         {
             if (m->isLinkedToDAW())
             {
-                linkedDisplays.push_back(m.get());
+                linkedDisplays.push_back(m);
             }
         }
 
         return linkedDisplays;
     }
 
-    int getNumTracks() { return mediaDisplays.size(); }
+    int getNumTracks()
+    {
+        return static_cast<int>(isThumbnailWidget() ? lazyTracks.size() : mediaDisplays.size());
+    }
 
     bool isInputWidget() { return (displayMode == 0) || isHybridWidget(); }
     bool isOutputWidget() { return (displayMode == 1) || isHybridWidget(); }
@@ -157,9 +168,39 @@ public:
         }
 
         mediaDisplays.clear();
+
+        for (auto& t : lazyTracks)
+        {
+            if (auto m = t->releaseDisplay())
+            {
+                m->removeChangeListener(this);
+            }
+
+            removeChildComponent(t.get());
+        }
+
+        lazyTracks.clear();
     }
 
     void addTrackFromComponentInfo(ComponentInfo info, bool fromDAW = false)
+    {
+        std::unique_ptr<MediaDisplayComponent> m = createDisplay(info, fromDAW);
+
+        if (m)
+        {
+            addAndMakeVisible(m.get());
+            mediaDisplays.push_back(std::move(m));
+
+            resized();
+
+            if (isThumbnailWidget())
+            {
+                mediaDisplays.back()->selectTrack();
+            }
+        }
+    }
+
+    std::unique_ptr<MediaDisplayComponent> createDisplay(ComponentInfo info, bool fromDAW)
     {
         std::shared_ptr<PyHarpComponentInfo> trackInfo = info.second;
         std::unique_ptr<MediaDisplayComponent> m;
@@ -191,22 +232,28 @@ public:
 
             m->setDisplayID(trackInfo->id);
             m->addChangeListener(this);
-            addAndMakeVisible(m.get());
-            mediaDisplays.push_back(std::move(m));
-
-            resized();
-
-            if (isThumbnailWidget())
-            {
-                mediaDisplays.back()->selectTrack();
-            }
         }
+
+        return m;
     }
 
     void addTrackFromFilePath(URL filePath, bool fromDAW = false)
     {
         File f = filePath.getLocalFile();
 
+        for (auto& t : lazyTracks)
+        {
+            if (t->isDuplicateFile(filePath))
+            {
+                selectLazyTrack(*t);
+
+                DBG("TrackAreaWidget::addTrackFromFilePath: Selecting existing track containing "
+                    << f.getFullPathName() << " instead of creating new track.");
+
+                return;
+            }
+        }
+
         for (auto& m : mediaDisplays)
         {
             if (m->isDuplicateFile(filePath))
@@ -251,7 +298,11 @@ public:
             validExt = false;
         }
 
-        if (validExt)
+        if (validExt && isThumbnailWidget())
+        {
+            addLazyTrack(componentInfo, filePath, fromDAW);
+        }
+        else if (validExt)
         {
             addTrackFromComponentInfo(componentInfo, fromDAW);
             mediaDisplays.back()->initializeDisplay(filePath);
@@ -264,6 +315,20 @@ public:
         mediaDisplay->removeChangeListener(this);
         removeChildComponent(mediaDisplay);
 
+        for (auto& t : lazyTracks)
+        {
+            if (t->getDisplay() == mediaDisplay)
+            {
+                removeChildComponent(t.get());
+            }
+        }
+
+        lazyTracks.erase(std::remove_if(lazyTracks.begin(),
+                                        lazyTracks.end(),
+                                        [mediaDisplay](const auto& ptr)
+                                        { return ptr->getDisplay() == mediaDisplay; }),
+                         lazyTracks.end());
+
         auto it =
             std::remove_if(mediaDisplays.begin(),
                            mediaDisplays.end(),
@@ -290,15 +355,145 @@ private:
         {
             bool wasTrackSelected = sourceDisplay->isCurrentlySelected();
 
-            for (auto& m : mediaDisplays)
+            for (auto* m : getExistingDisplays())
             {
-                if (source != m.get() && wasTrackSelected)
+                if (source != m && wasTrackSelected)
                 {
                     m->deselectTrack();
                 }
             }
 
             sendSynchronousChangeMessage();
+
+            // Deselected tracks may no longer need their display
+            triggerAsyncUpdate();
+        }
+    }
+
+    std::vector<Component*> getTrackComponents()
+    {
+        std::vector<Component*> trackComponents;
+
+        for (auto& m : mediaDisplays)
+        {
+            trackComponents.push_back(m.get());
+        }
+
+        for (auto& t : lazyTracks)
+        {
+            trackComponents.push_back(t.get());
+        }
+
+        return trackComponents;
+    }
+
+    std::vector<MediaDisplayComponent*> getExistingDisplays()
+    {
+        std::vector<MediaDisplayComponent*> displays;
+
+        for (auto& m : mediaDisplays)
+        {
+            displays.push_back(m.get());
+        }
+
+        for (auto& t : lazyTracks)
+        {
+            if (auto* m = t->getDisplay())
+            {
+                displays.push_back(m);
+            }
+        }
+
+        return displays;
+    }
+
+    void addLazyTrack(ComponentInfo info, URL filePath, bool fromDAW)
+    {
+        auto t = std::make_unique<LazyTrackComponent>(info, filePath, filePath.getFileName(), fromDAW);
+
+        LazyTrackComponent* track = t.get();
+        t->onPlaceholderClicked = [this, track] { selectLazyTrack(*track); };
+
+        addAndMakeVisible(t.get());
+        lazyTracks.push_back(std::move(t));
+
+        resized();
+
+        selectLazyTrack(*track);
+    }
+
+    void selectLazyTrack(LazyTrackComponent& track)
+    {
+        if (createDisplayFor(track))
+        {
+            track.getDisplay()->selectTrack();
+        }
+    }
+
+    bool createDisplayFor(LazyTrackComponent& track)
+    {
+        if (track.getDisplay() != nullptr)
+        {
+            return true;
+        }
+
+        std::unique_ptr<MediaDisplayComponent> m =
+            createDisplay(track.getComponentInfo(), track.isLinkedToDAW());
+
+        if (! m)
+        {
+            return false;
+        }
+
+        String name = track.getTrackName();
+
+        track.setDisplay(std::move(m));
+        track.getDisplay()->initializeDisplay(track.getFilePath());
+        track.getDisplay()->setTrackName(name);
+
+        return true;
+    }
+
+    void handleAsyncUpdate() override { updateLazyTracks(); }
+
+    /*
+      Only tracks near the visible part of the track area keep a display, along
+      with the selected track (which may be playing) and DAW-linked tracks (which
+      other widgets hold on to). Everything else is reduced to a placeholder.
+    */
+    void updateLazyTracks()
+    {
+        if (lazyTracks.empty())
+        {
+            return;
+        }
+
+        Rectangle<int> visibleArea = getLocalBounds();
+
+        if (auto* parent = getParentComponent())
+        {
+            visibleArea = visibleArea.getIntersection(
+                getLocalArea(parent, parent->getLocalBounds()));
+        }
+
+        // Prepare tracks just outside of view, so they are ready when scrolled to
+        visibleArea = visibleArea.expanded(0, jmax(fixedTrackHeight, visibleArea.getHeight() / 2));
+
+        for (auto& t : lazyTracks)
+        {
+            MediaDisplayComponent* m = t->getDisplay();
+
+            bool isNeeded = t->getBounds().intersects(visibleArea) || t->isLinkedToDAW()
+                            || (m != nullptr && m->isCurrentlySelected());
+
+            if (isNeeded)
+            {
+                createDisplayFor(*t);
+            }
+            else if (m != nullptr)
+            {
+                t->releaseDisplay()->removeChangeListener(this);
+            }
         }
     }
 
@@ -310,4 +505,7 @@ private:
     int minTotalHeight = 0;
 
     std::vector<std::unique_ptr<MediaDisplayComponent>> mediaDisplays;
+
+    // Tracks of a thumbnail widget (e.g., the media clipboard), created lazily
+    std::vector<std::unique_ptr<LazyTrackComponent>> lazyTracks;
 };
@@ -0,0 +1,75 @@
+/**
+ * @file AudioReadAheadPoolTests.cpp
+ * @brief Checks the read-ahead thread count stays bounded with many audio tracks
+ */
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "media/AudioReadAheadPool.h"
+
+#include <set>
+
+class AudioReadAheadPoolTests : public UnitTest
+{
+public:
+    AudioReadAheadPoolTests() : UnitTest("AudioReadAheadPool", "Media") {}
+
+    void runTest() override
+    {
+        AudioReadAheadPool pool;
+
+        AudioBuffer<float> silence(2, 44100);
+        silence.clear();
+
+        // Transports of tracks which were loaded but never played, and of playing ones
+        std::vector<TimeSliceThread*> assignedThreads;
+        std::vector<std::unique_ptr<BufferingAudioSource>> sources;
+
+        beginTest("Tracks are spread over a bounded number of threads");
+
+        for (int trackIdx = 0; trackIdx < numTracks; ++trackIdx)
+        {
+            TimeSliceThread* thread = pool.acquireThread();
+            assignedThreads.push_back(thread);
+
+            sources.push_back(std::make_unique<BufferingAudioSource>(
+                new MemoryAudioSource(silence, true), *thread, true, 4096, 2, false));
+
+            if (trackIdx % 2 == 0)
+            {
+                sources.back()->prepareToPlay(512, 44100.0);
+            }
+        }
+
+        std::set<TimeSliceThread*> distinctThreads(assignedThreads.begin(), assignedThreads.end());
+
+        expect(pool.getNumThreads() <= 4);
+        expectEquals(static_cast<int>(distinctThreads.size()), pool.getNumThreads());
+
+        for (int threadIdx = 0; threadIdx < pool.getNumThreads(); ++threadIdx)
+        {
+            int expectedNumAssigned = numTracks / pool.getNumThreads();
+
+            expect(std::abs(pool.getNumAssigned(threadIdx) - expectedNumAssigned) <= 1);
+        }
+
+        beginTest("Released threads are no longer counted");
+
+        sources.clear();
+
+        for (TimeSliceThread* thread : assignedThreads)
+        {
+            pool.releaseThread(thread);
+        }
+
+        for (int threadIdx = 0; threadIdx < pool.getNumThreads(); ++threadIdx)
+        {
+            expectEquals(pool.getNumAssigned(threadIdx), 0);
+        }
+    }
+
+private:
+    static constexpr int numTracks = 300;
+};
+
+static AudioReadAheadPoolTests audioReadAheadPoolTests;
@@ -0,0 +1,114 @@
+/**
+ * @file SynthAudioSourceTests.cpp
+ * @brief Checks MIDI playback cost does not grow with the length of the sequence
+ */
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "pianoroll/SynthAudioSource.h"
+
+class SynthAudioSourceTests : public UnitTest
+{
+public:
+    SynthAudioSourceTests() : UnitTest("SynthAudioSource", "Media") {}
+
+    void runTest() override
+    {
+        beginTest("Seeks are applied on the next block");
+
+        {
+            SynthAudioSource source;
+            source.useSequence(makeSequence(numShortEvents));
+            source.prepareToPlay(blockSize, sampleRate);
+
+            source.setNextReadPosition(blockSize * 10);
+            expectEquals(source.getNextReadPosition(), static_cast<int64>(blockSize * 10));
+
+            AudioBuffer<float> buffer(2, blockSize);
+            source.getNextAudioBlock(AudioSourceChannelInfo(buffer));
+
+            expectEquals(source.getNextReadPosition(), static_cast<int64>(blockSize * 11));
+        }
+
+        beginTest("Blocks of a 500k-event sequence cost as much as those of a short one");
+
+        // Same density of events, so only the length of the sequence differs
+        double shortSeconds = timeBlocks(numShortEvents, 0);
+        double longSeconds = timeBlocks(numLongEvents, numLongEvents / 2);
+
+        logMessage("Seconds per " + String(numTimedBlocks) + " blocks, "
+                   + String(numShortEvents) + " events: " + String(shortSeconds) + ", "
+                   + String(numLongEvents) + " events: " + String(longSeconds));
+
+        // Visiting every event on each block would make the long sequence ~1000x slower
+        expect(longSeconds < shortSeconds * 4.0 + 0.01);
+    }
+
+private:
+    // Alternating note on and off messages, one every 10 ms
+    static MidiMessageSequence makeSequence(int numEvents)
+    {
+        MidiMessageSequence sequence;
+
+        for (int eventIdx = 0; eventIdx < numEvents; ++eventIdx)
+        {
+            int noteNumber = 48 + (eventIdx / 2) % 24;
+            double time = eventIdx * eventSpacing;
+
+            sequence.addEvent(eventIdx % 2 == 0
+                                  ? MidiMessage::noteOn(1, noteNumber, 0.8f).withTimeStamp(time)
+                                  : MidiMessage::noteOff(1, noteNumber).withTimeStamp(time));
+        }
+
+        sequence.updateMatchedPairs();
+
+        return sequence;
+    }
+
+    // Best of a few runs of numTimedBlocks blocks, starting at the given event
+    static double timeBlocks(int numEvents, int startEventIdx)
+    {
+        SynthAudioSource source;
+        source.useSequence(makeSequence(numEvents));
+        source.prepareToPlay(blockSize, sampleRate);
+
+        AudioBuffer<float> buffer(2, blockSize);
+        AudioSourceChannelInfo info(buffer);
+
+        auto startPosition = static_cast<int64>(startEventIdx * eventSpacing * sampleRate);
+
+        double bestSeconds = std::numeric_limits<double>::max();
+
+        for (int runIdx = 0; runIdx < numRuns; ++runIdx)
+        {
+            source.setNextReadPosition(startPosition);
+            source.resetNotes();
+
+            int64 startTicks = Time::getHighResolutionTicks();
+
+            for (int blockIdx = 0; blockIdx < numTimedBlocks; ++blockIdx)
+            {
+                source.getNextAudioBlock(info);
+            }
+
+            bestSeconds = jmin(bestSeconds,
+                               Time::highResolutionTicksToSeconds(
+                                   Time::getHighResolutionTicks() - startTicks));
+        }
+
+        return bestSeconds;
+    }
+
+    static constexpr int numShortEvents = 500;
+    static constexpr int numLongEvents = 500000;
+
+    static constexpr double eventSpacing = 0.01;
+    static constexpr double sampleRate = 44100.0;
+    static constexpr int blockSize = 512;
+
+    // About 4.6 seconds of audio, which fits within the short sequence
+    static constexpr int numTimedBlocks = 400;
+    static constexpr int numRuns = 3;
+};
+
+static SynthAudioSourceTests synthAudioSourceTests;
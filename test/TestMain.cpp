@@ -0,0 +1,24 @@
+/**
+ * @file TestMain.cpp
+ * @brief Runs every registered JUCE unit test, failing if any of them fails
+ */
+
+#include <juce_core/juce_core.h>
+
+using namespace juce;
+
+int main()
+{
+    UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runAllTests();
+
+    int numFailures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+    {
+        numFailures += runner.getResult(i)->failures;
+    }
+
+    return numFailures > 0 ? 1 : 0;
+}